@@ -12,7 +12,16 @@
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <type_traits>
 #include <istream>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BB_BINARY_READER_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define BB_BINARY_READER_X86_SIMD 0
+#endif
 
 namespace bb {
     enum class byte_order_t {
@@ -26,6 +35,59 @@ namespace bb {
         return *reinterpret_cast<uint8_t const*>(&flag) == 0x01 ? byte_order_t::little_endian : byte_order_t::big_endian;
     }
     
+    // same as native_byte_order(), but for template arguments
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    constexpr byte_order_t native_byte_order_constant = byte_order_t::big_endian;
+#else
+    constexpr byte_order_t native_byte_order_constant = byte_order_t::little_endian;
+#endif
+
+    // compilers make them a single bswap instruction
+    inline uint8_t byte_swap(uint8_t const value) {
+        return value;
+    }
+    
+    inline uint16_t byte_swap(uint16_t const value) {
+        return static_cast<uint16_t>((value >> 8) | (value << 8));
+    }
+    
+    inline uint32_t byte_swap(uint32_t const value) {
+        return (value >> 24) | ((value >> 8) & 0x0000FF00) | ((value << 8) & 0x00FF0000) | (value << 24);
+    }
+    
+    inline uint64_t byte_swap(uint64_t const value) {
+        return (static_cast<uint64_t>(byte_swap(static_cast<uint32_t>(value))) << 32) | byte_swap(static_cast<uint32_t>(value >> 32));
+    }
+    
+    template <typename _T>
+    inline _T byte_swap_signed(_T const value) {
+        using unsigned_t = typename std::make_unsigned<_T>::type;
+        return static_cast<_T>(byte_swap(static_cast<unsigned_t>(value)));
+    }
+    
+    inline int16_t byte_swap(int16_t const value) {
+        return byte_swap_signed(value);
+    }
+    
+    inline int32_t byte_swap(int32_t const value) {
+        return byte_swap_signed(value);
+    }
+    
+    inline int64_t byte_swap(int64_t const value) {
+        return byte_swap_signed(value);
+    }
+    
+    // Loads a value recorded in _ByteOrder from unaligned ptr
+    template <typename _T, byte_order_t _ByteOrder>
+    inline _T load(uint8_t const* ptr) {
+        _T value;
+        std::memcpy(&value, ptr, sizeof(_T));
+        if (_ByteOrder != byte_order_t::native && _ByteOrder != native_byte_order_constant) {
+            value = byte_swap(value);
+        }
+        return value;
+    }
+    
     struct memory_reader {
         uint8_t const* ptr_;
         size_t size_;
@@ -144,6 +206,12 @@ namespace bb {
         return binary_readable_policy::template read<_T>(readable, byte_order);
     }
     
+    // _ByteOrder: fixed at compile time, e.g. read<uint32_t, byte_order_t::big_endian>(readable)
+    template <typename _T, byte_order_t _ByteOrder, typename _Readable, typename binary_readable_policy = binary_readable_traits<_Readable>>
+    inline _T read(_Readable& readable) {
+        return binary_readable_policy::template read<_T, _ByteOrder>(readable);
+    }
+    
     template <typename _T, typename _Readable, typename binary_readable_policy = binary_readable_traits<_Readable>>
     inline _T peek(_Readable& readable) {
         return binary_readable_policy::template peek<_T>(readable);
@@ -164,6 +232,11 @@ namespace bb {
         return binary_readable_policy::template peek<_T>(readable, cursor, byte_order);
     }
     
+    template <typename _T, byte_order_t _ByteOrder, typename _Readable, typename binary_readable_policy = binary_readable_traits<_Readable>>
+    inline _T peek(_Readable& readable, size_t const cursor) {
+        return binary_readable_policy::template peek<_T, _ByteOrder>(readable, cursor);
+    }
+    
     // extension memory_reader
     
     template <>
@@ -213,7 +286,7 @@ namespace bb {
         static inline _T peek(memory_reader& reader, size_t const cursor) {
             return *reinterpret_cast<_T const*>(reader.ptr() + cursor);
         }
-
+        
         template <typename _T>
         static inline _T peek(memory_reader& reader, size_t const cursor, byte_order_t const byte_order) {
             if (byte_order == byte_order_t::little_endian) {
@@ -235,6 +308,18 @@ namespace bb {
                 return peek<_T>(reader, cursor);
             }
         }
+        
+        template <typename _T, byte_order_t _ByteOrder>
+        static inline _T read(memory_reader& reader) {
+            auto value = load<_T, _ByteOrder>(reader.ptr() + reader.cursor());
+            reader.move(sizeof(_T));
+            return value;
+        }
+        
+        template <typename _T, byte_order_t _ByteOrder>
+        static inline _T peek(memory_reader& reader, size_t const cursor) {
+            return load<_T, _ByteOrder>(reader.ptr() + cursor);
+        }
     };
     
     // for optimization
@@ -273,6 +358,111 @@ namespace bb {
         return reader.peek(cursor);
     }
     
+    // bulk byte swap: copies arrays of 16/32-bit values with reversing the byte order of each value
+    
+    inline void swap_bytes_copy16_scalar(uint8_t* dst, uint8_t const* src, size_t const count) {
+        for (size_t i = 0; i < count; ++i) {
+            auto value = byte_swap(load<uint16_t, byte_order_t::native>(src + 2 * i));
+            std::memcpy(dst + 2 * i, &value, 2);
+        }
+    }
+    
+    inline void swap_bytes_copy32_scalar(uint8_t* dst, uint8_t const* src, size_t const count) {
+        for (size_t i = 0; i < count; ++i) {
+            auto value = byte_swap(load<uint32_t, byte_order_t::native>(src + 4 * i));
+            std::memcpy(dst + 4 * i, &value, 4);
+        }
+    }
+
+#if BB_BINARY_READER_X86_SIMD
+    __attribute__((target("ssse3")))
+    inline void swap_bytes_copy_ssse3(uint8_t* dst, uint8_t const* src, size_t const size, __m128i const mask) {
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            auto value = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(value, mask));
+        }
+    }
+    
+    __attribute__((target("avx2")))
+    inline void swap_bytes_copy_avx2(uint8_t* dst, uint8_t const* src, size_t const size, __m128i const mask) {
+        auto const mask256 = _mm256_broadcastsi128_si256(mask);
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            auto value = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(value, mask256));
+        }
+        // remaining 16 bytes
+        for (; i + 16 <= size; i += 16) {
+            auto value = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(value, mask));
+        }
+    }
+#endif
+
+    enum class simd_level_t {
+        scalar,
+        ssse3,
+        avx2,
+    };
+    
+    inline simd_level_t simd_level() {
+#if BB_BINARY_READER_X86_SIMD
+        static simd_level_t const level = []() {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return simd_level_t::avx2;
+            }
+            if (__builtin_cpu_supports("ssse3")) {
+                return simd_level_t::ssse3;
+            }
+            return simd_level_t::scalar;
+        }();
+        return level;
+#else
+        return simd_level_t::scalar;
+#endif
+    }
+    
+    // word_size: 2 or 4
+    inline void swap_bytes_copy(uint8_t* dst, uint8_t const* src, size_t const count, size_t const word_size, simd_level_t const level = simd_level()) {
+        size_t done = 0;
+#if BB_BINARY_READER_X86_SIMD
+        if (level != simd_level_t::scalar) {
+            auto const mask = word_size == 2
+                ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+                : _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+            auto const size = count * word_size;
+            if (level == simd_level_t::avx2) {
+                swap_bytes_copy_avx2(dst, src, size, mask);
+            }
+            else {
+                swap_bytes_copy_ssse3(dst, src, size, mask);
+            }
+            done = size / 16 * 16 / word_size;
+        }
+#else
+        (void)level;
+#endif
+        if (word_size == 2) {
+            swap_bytes_copy16_scalar(dst + done * 2, src + done * 2, count - done);
+        }
+        else {
+            swap_bytes_copy32_scalar(dst + done * 4, src + done * 4, count - done);
+        }
+    }
+    
+    // Copies count values of _T (uint16_t or uint32_t) at the cursor into dst with converting to the native byte order
+    template <typename _T>
+    inline void peek_array(memory_reader& reader, size_t const cursor, _T* dst, size_t const count, byte_order_t const byte_order) {
+        static_assert(sizeof(_T) == 2 || sizeof(_T) == 4, "_T must be 16-bit or 32-bit");
+        if (byte_order == byte_order_t::native || byte_order == native_byte_order()) {
+            reader.peek(cursor, reinterpret_cast<uint8_t*>(dst), count * sizeof(_T));
+            return;
+        }
+        swap_bytes_copy(reinterpret_cast<uint8_t*>(dst), reader.ptr() + cursor, count, sizeof(_T));
+    }
+    
     // extension std::istream
     
     template <>
@@ -286,24 +476,114 @@ namespace bb {
         
         template <typename _T>
         static inline _T read(std::istream& is, byte_order_t const byte_order) {
-            if (byte_order == byte_order_t::little_endian) {
-                _T value = read<uint8_t>(is);
-                for (auto i = 1; i < sizeof(_T); ++i) {
-                    value |= static_cast<_T>(read<uint8_t>(is)) << (8 * i);
-                }
-                return value;
+            // read at once, and then convert the byte order
+            uint8_t buf[sizeof(_T)];
+            is.read(reinterpret_cast<char*>(buf), sizeof(_T));
+            memory_reader mr(buf, sizeof(_T));
+            return binary_readable_traits<memory_reader>::read<_T>(mr, byte_order);
+        }
+    };
+    
+    // reads chunks of std::istream directly from its std::streambuf to parse them with memory_reader
+    struct istream_chunk_reader {
+        std::istream& is_;
+        std::vector<uint8_t> buffer_;
+        size_t last_size_ = 0; // of the last chunk in buffer_
+        uint64_t position_ = 0; // read or skipped bytes
+        
+        explicit istream_chunk_reader(std::istream& is)
+        : is_(is) {
+        }
+        
+        // from the position of the stream when constructed
+        inline uint64_t position() const {
+            return position_;
+        }
+        
+        // Returns memory_reader refers to the internal buffer, which is valid until the next read.
+        // The size of it is less than the specified size if the stream reached the end.
+        inline memory_reader read(size_t const size) {
+            if (buffer_.size() < size) {
+                buffer_.resize(size);
             }
-            else if (byte_order == byte_order_t::big_endian) {
-                _T value = read<uint8_t>(is);
-                for (auto i = 1; i < sizeof(_T); ++i) {
-                    value <<= 8;
-                    value |= read<uint8_t>(is);
-                }
-                return value;
+            auto streambuf = is_.rdbuf();
+            std::streamsize read_size = 0;
+            if (streambuf) {
+                read_size = streambuf->sgetn(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(size));
             }
-            else {
-                return read<_T>(is);
+            last_size_ = static_cast<size_t>(read_size);
+            position_ += static_cast<uint64_t>(read_size);
+            return memory_reader(buffer_.data(), last_size_);
+        }
+        
+        // Reads more data following the last chunk. Returns memory_reader refers to both of them.
+        inline memory_reader extend(size_t const size) {
+            if (buffer_.size() < last_size_ + size) {
+                buffer_.resize(last_size_ + size);
+            }
+            auto streambuf = is_.rdbuf();
+            std::streamsize read_size = 0;
+            if (streambuf) {
+                read_size = streambuf->sgetn(reinterpret_cast<char*>(buffer_.data() + last_size_), static_cast<std::streamsize>(size));
+            }
+            last_size_ += static_cast<size_t>(read_size);
+            position_ += static_cast<uint64_t>(read_size);
+            return memory_reader(buffer_.data(), last_size_);
+        }
+        
+        // Seeks if the stream is seekable, otherwise ignores. Returns false if the stream reached the end.
+        inline bool skip(size_t const size) {
+            auto streambuf = is_.rdbuf();
+            if (!streambuf) {
+                return false;
+            }
+            auto const current = streambuf->pubseekoff(0, std::ios::cur, std::ios::in);
+            if (current != std::streampos(-1)) {
+                auto const end = streambuf->pubseekoff(0, std::ios::end, std::ios::in);
+                auto const target = current + static_cast<std::streamoff>(size);
+                streambuf->pubseekpos(target < end ? target : end, std::ios::in);
+                position_ += static_cast<uint64_t>((target < end ? target : end) - current);
+                return target <= end;
+            }
+            is_.ignore(static_cast<std::streamsize>(size));
+            position_ += static_cast<uint64_t>(is_.gcount());
+            return static_cast<size_t>(is_.gcount()) == size;
+        }
+    };
+    
+    // same as istream_chunk_reader, but for data in memory (chunks refer to it without copying)
+    struct memory_chunk_reader {
+        uint8_t const* ptr_;
+        size_t size_;
+        size_t last_position_ = 0; // of the last chunk
+        size_t position_ = 0;
+        
+        memory_chunk_reader(uint8_t const* ptr, size_t const size)
+        : ptr_(ptr), size_(size) {
+        }
+        
+        inline uint64_t position() const {
+            return position_;
+        }
+        
+        inline memory_reader read(size_t const size) {
+            last_position_ = position_;
+            position_ += size < size_ - position_ ? size : size_ - position_;
+            return memory_reader(ptr_ + last_position_, position_ - last_position_);
+        }
+        
+        inline memory_reader extend(size_t const size) {
+            position_ += size < size_ - position_ ? size : size_ - position_;
+            return memory_reader(ptr_ + last_position_, position_ - last_position_);
+        }
+        
+        inline bool skip(size_t const size) {
+            if (size_ - position_ < size) {
+                position_ = size_;
+                return false;
             }
+            position_ += size;
+            return true;
         }
     };
 }
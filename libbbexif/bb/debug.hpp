@@ -12,6 +12,7 @@
 #include <chrono>
 #include <cstdio>
 #include <cstdarg>
+#include <ctime>
 #include <string>
 #include <iomanip>
 
@@ -27,8 +28,15 @@ namespace bb {
         vsnprintf(buf, sizeof(buf), format, arg);
         va_end(arg);
         
+        // std::localtime() is not thread-safe
+        std::tm tm;
+#if defined(_WIN32)
+        localtime_s(&tm, &time);
+#else
+        localtime_r(&time, &tm);
+#endif
         std::stringstream ss;
-        ss << std::put_time(std::localtime(&time), "%F %T.") << std::setw(6) << std::setfill('0') << time_usec << " " << buf;
+        ss << std::put_time(&tm, "%F %T.") << std::setw(6) << std::setfill('0') << time_usec << " " << buf;
         return ss.str();
     }
     
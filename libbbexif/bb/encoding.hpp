@@ -0,0 +1,86 @@
+//
+//  encoding.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ Table-driven binary to text encoders, appending to std::string in place:
+ - hex: lowercase, with an optional separator between bytes (e.g. "ff,d8,ff")
+ - base64: RFC 4648, with padding
+``` */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace bb {
+    struct hex_table_t {
+        char digits[256][2];
+    };
+    
+    inline hex_table_t const& hex_table() {
+        static hex_table_t const table = []() {
+            static char const* const hex = "0123456789abcdef";
+            hex_table_t table;
+            for (size_t i = 0; i < 256; ++i) {
+                table.digits[i][0] = hex[i >> 4];
+                table.digits[i][1] = hex[i & 0x0F];
+            }
+            return table;
+        }();
+        return table;
+    }
+    
+    // separator: '\0' means no separator
+    inline void append_hex(std::string& str, uint8_t const* ptr, size_t const size, char const separator = '\0') {
+        if (size == 0) {
+            return;
+        }
+        auto const& table = hex_table();
+        auto const stride = separator == '\0' ? 2 : 3;
+        auto const position = str.size();
+        str.resize(position + size * stride - (stride - 2));
+        auto out = &str[position];
+        if (separator == '\0') {
+            for (size_t i = 0; i < size; ++i, out += 2) {
+                std::memcpy(out, table.digits[ptr[i]], 2);
+            }
+        }
+        else {
+            for (size_t i = 0; i + 1 < size; ++i, out += 3) {
+                std::memcpy(out, table.digits[ptr[i]], 2);
+                out[2] = separator;
+            }
+            std::memcpy(out, table.digits[ptr[size - 1]], 2);
+        }
+    }
+    
+    inline void append_base64(std::string& str, uint8_t const* ptr, size_t const size) {
+        static char const* const alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        auto const position = str.size();
+        str.resize(position + (size + 2) / 3 * 4);
+        auto out = &str[position];
+        size_t i = 0;
+        for (; i + 3 <= size; i += 3, out += 4) {
+            uint32_t const bits = (ptr[i] << 16) | (ptr[i + 1] << 8) | ptr[i + 2];
+            out[0] = alphabet[bits >> 18];
+            out[1] = alphabet[(bits >> 12) & 0x3F];
+            out[2] = alphabet[(bits >> 6) & 0x3F];
+            out[3] = alphabet[bits & 0x3F];
+        }
+        if (i < size) {
+            uint32_t const bits = (ptr[i] << 16) | (i + 1 < size ? ptr[i + 1] << 8 : 0);
+            out[0] = alphabet[bits >> 18];
+            out[1] = alphabet[(bits >> 12) & 0x3F];
+            out[2] = i + 1 < size ? alphabet[(bits >> 6) & 0x3F] : '=';
+            out[3] = '=';
+        }
+    }
+}
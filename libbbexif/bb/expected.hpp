@@ -0,0 +1,100 @@
+//
+//  expected.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ A minimal std::expected (C++23) for C++14, holds a value or an error:
+ - _T must be default constructible, the value is left default constructed on error
+ - accessors do not check nor throw, check has_value() at first
+``` */
+
+#include <type_traits>
+#include <utility>
+
+namespace bb {
+    template <typename _E>
+    struct unexpected {
+        _E error_;
+    };
+    
+    template <typename _E>
+    inline unexpected<typename std::decay<_E>::type> make_unexpected(_E&& error) {
+        return {std::forward<_E>(error)};
+    }
+    
+    template <typename _T, typename _E>
+    struct expected {
+        bool has_value_;
+        _T value_;
+        _E error_;
+        
+        expected()
+        : has_value_(true), value_(), error_() {
+        }
+        
+        expected(_T const& value)
+        : has_value_(true), value_(value), error_() {
+        }
+        
+        expected(_T&& value)
+        : has_value_(true), value_(std::move(value)), error_() {
+        }
+        
+        template <typename _G>
+        expected(unexpected<_G> const& error)
+        : has_value_(false), value_(), error_(error.error_) {
+        }
+        
+        template <typename _G>
+        expected(unexpected<_G>&& error)
+        : has_value_(false), value_(), error_(std::move(error.error_)) {
+        }
+        
+        inline bool has_value() const noexcept {
+            return has_value_;
+        }
+        
+        inline explicit operator bool() const noexcept {
+            return has_value_;
+        }
+        
+        inline _T& value() & noexcept {
+            return value_;
+        }
+        
+        inline _T const& value() const& noexcept {
+            return value_;
+        }
+        
+        inline _T&& value() && noexcept {
+            return std::move(value_);
+        }
+        
+        inline _T& operator*() & noexcept {
+            return value_;
+        }
+        
+        inline _T const& operator*() const& noexcept {
+            return value_;
+        }
+        
+        inline _T* operator->() noexcept {
+            return &value_;
+        }
+        
+        inline _T const* operator->() const noexcept {
+            return &value_;
+        }
+        
+        inline _E const& error() const noexcept {
+            return error_;
+        }
+    };
+}
@@ -0,0 +1,183 @@
+//
+//  file_chunk_reader.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ Reads chunks of a file with pread(), same interface as bb::istream_chunk_reader:
+ - open() reads a prefix of the file at once (e.g. 64KB), chunks in it need no more I/O
+ - a chunk beyond the prefix is read by a targeted pread() of the missing bytes only
+ - skipped bytes are not read
+``` */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "binary_reader.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BB_FILE_CHUNK_READER_AVAILABLE 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#else
+#define BB_FILE_CHUNK_READER_AVAILABLE 0
+#endif
+
+namespace bb {
+    struct file_chunk_reader {
+        int fd_ = -1;
+        bool closes_fd_ = false; // false if opened by the caller
+        uint64_t file_size_ = 0;
+        std::vector<uint8_t>& buffer_; // caches [base_, base_ + filled_) of the file
+        uint64_t base_ = 0;
+        size_t filled_ = 0;
+        uint64_t last_position_ = 0; // of the last chunk
+        uint64_t position_ = 0;
+        size_t number_of_reads_ = 0;
+        uint64_t bytes_read_ = 0;
+        
+        // buffer: reused between readers (e.g. for each thread)
+        explicit file_chunk_reader(std::vector<uint8_t>& buffer) noexcept
+        : buffer_(buffer) {
+        }
+        
+        file_chunk_reader(file_chunk_reader const&) = delete;
+        file_chunk_reader const& operator=(file_chunk_reader const&) = delete;
+        
+        ~file_chunk_reader() {
+            close();
+        }
+        
+        // Returns false if the file is not a regular file (e.g. not found, pipe), then use std::istream instead
+        inline bool open(char const* filepath, size_t const prefix_size) {
+            close();
+#if BB_FILE_CHUNK_READER_AVAILABLE
+            auto const fd = ::open(filepath, O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            if (!open(fd, prefix_size)) {
+                ::close(fd);
+                return false;
+            }
+            closes_fd_ = true;
+            return true;
+#else
+            (void)filepath;
+            (void)prefix_size;
+            return false;
+#endif
+        }
+        
+        // fd: opened by the caller, who closes it after this reader
+        inline bool open(int const fd, size_t const prefix_size) {
+            close();
+#if BB_FILE_CHUNK_READER_AVAILABLE
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+                return false;
+            }
+            fd_ = fd;
+            file_size_ = static_cast<uint64_t>(st.st_size);
+            fill(0, static_cast<size_t>(prefix_size < file_size_ ? prefix_size : file_size_));
+            return true;
+#else
+            (void)fd;
+            (void)prefix_size;
+            return false;
+#endif
+        }
+        
+        inline void close() noexcept {
+#if BB_FILE_CHUNK_READER_AVAILABLE
+            if (fd_ >= 0 && closes_fd_) {
+                ::close(fd_);
+            }
+#endif
+            fd_ = -1;
+            closes_fd_ = false;
+            file_size_ = 0;
+            base_ = 0;
+            filled_ = 0;
+            last_position_ = 0;
+            position_ = 0;
+            number_of_reads_ = 0;
+            bytes_read_ = 0;
+        }
+        
+        inline uint64_t position() const {
+            return position_;
+        }
+        
+        inline size_t number_of_reads() const {
+            return number_of_reads_;
+        }
+        
+        inline uint64_t bytes_read() const {
+            return bytes_read_;
+        }
+        
+        // Returns memory_reader refers to the buffer, which is valid until the next read.
+        inline memory_reader read(size_t const size) {
+            last_position_ = position_;
+            return extend(size);
+        }
+        
+        // Reads more data following the last chunk. Returns memory_reader refers to both of them.
+        inline memory_reader extend(size_t const size) {
+            auto const end = position_ + size < file_size_ ? position_ + size : file_size_;
+            if (last_position_ < base_ || base_ + filled_ < last_position_) {
+                // not contiguous to the cached range
+                base_ = last_position_;
+                filled_ = 0;
+            }
+            if (base_ + filled_ < end) {
+                fill(base_ + filled_, static_cast<size_t>(end - (base_ + filled_)));
+            }
+            if (base_ + filled_ < end) {
+                position_ = base_ + filled_;
+            }
+            else {
+                position_ = end;
+            }
+            return memory_reader(buffer_.data() + (last_position_ - base_), static_cast<size_t>(position_ - last_position_));
+        }
+        
+        inline bool skip(size_t const size) {
+            if (file_size_ - position_ < size) {
+                position_ = file_size_;
+                return false;
+            }
+            position_ += size;
+            return true;
+        }
+        
+        // Reads [offset, offset + size) of the file to the end of the cached range
+        inline void fill(uint64_t const offset, size_t const size) {
+#if BB_FILE_CHUNK_READER_AVAILABLE
+            if (buffer_.size() < filled_ + size) {
+                buffer_.resize(filled_ + size);
+            }
+            size_t done = 0;
+            while (done < size) {
+                auto const n = ::pread(fd_, buffer_.data() + filled_ + done, size - done, static_cast<off_t>(offset + done));
+                if (n <= 0) {
+                    break;
+                }
+                done += static_cast<size_t>(n);
+            }
+            ++number_of_reads_;
+            bytes_read_ += done;
+            filled_ += done;
+#endif
+        }
+    };
+}
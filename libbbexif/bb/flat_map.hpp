@@ -0,0 +1,140 @@
+//
+//  flat_map.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace bb {
+    // std::map like container on a sorted std::vector
+    // - iterators are invalidated by insertion
+    // - keys must not be modified through iterators
+    template <typename _Key, typename _T>
+    struct flat_map {
+        using key_type = _Key;
+        using mapped_type = _T;
+        using value_type = std::pair<_Key, _T>;
+        using container_type = std::vector<value_type>;
+        using size_type = typename container_type::size_type;
+        using iterator = typename container_type::iterator;
+        using const_iterator = typename container_type::const_iterator;
+        
+        container_type values_;
+        
+        inline iterator begin() noexcept { return values_.begin(); }
+        inline iterator end() noexcept { return values_.end(); }
+        inline const_iterator begin() const noexcept { return values_.begin(); }
+        inline const_iterator end() const noexcept { return values_.end(); }
+        
+        inline size_type size() const noexcept { return values_.size(); }
+        inline bool empty() const noexcept { return values_.empty(); }
+        inline void reserve(size_type const size) { values_.reserve(size); }
+        inline void clear() noexcept { values_.clear(); }
+        
+        inline iterator lower_bound(key_type const& key) {
+            return values_.begin() + lower_bound_index(key);
+        }
+        
+        inline const_iterator lower_bound(key_type const& key) const {
+            return values_.begin() + lower_bound_index(key);
+        }
+        
+        inline iterator find(key_type const& key) {
+            auto it = lower_bound(key);
+            return it != end() && !(key < it->first) ? it : end();
+        }
+        
+        inline const_iterator find(key_type const& key) const {
+            auto it = lower_bound(key);
+            return it != end() && !(key < it->first) ? it : end();
+        }
+        
+        inline size_type count(key_type const& key) const {
+            return find(key) != end() ? 1 : 0;
+        }
+        
+        inline mapped_type& at(key_type const& key) {
+            auto it = find(key);
+            if (it == end()) {
+                throw std::out_of_range("bb::flat_map::at");
+            }
+            return it->second;
+        }
+        
+        inline mapped_type const& at(key_type const& key) const {
+            auto it = find(key);
+            if (it == end()) {
+                throw std::out_of_range("bb::flat_map::at");
+            }
+            return it->second;
+        }
+        
+        inline mapped_type& operator[](key_type const& key) {
+            return emplace(key, mapped_type()).first->second;
+        }
+        
+        // Does nothing if the key already exists, like std::map
+        template <typename... _Args>
+        inline std::pair<iterator, bool> emplace(key_type const& key, _Args&&... args) {
+            // Appending is the usual case, because IFD entries are recorded in ascending order
+            if (values_.empty() || values_.back().first < key) {
+                values_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<_Args>(args)...));
+                return {values_.end() - 1, true};
+            }
+            auto it = lower_bound(key);
+            if (!(key < it->first)) {
+                return {it, false};
+            }
+            it = values_.emplace(it, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<_Args>(args)...));
+            return {it, true};
+        }
+        
+        // hint: ignored, for compatibility with std::map
+        template <typename... _Args>
+        inline iterator emplace_hint(const_iterator, key_type const& key, _Args&&... args) {
+            return emplace(key, std::forward<_Args>(args)...).first;
+        }
+        
+        inline std::pair<iterator, bool> insert(value_type value) {
+            return emplace(value.first, std::move(value.second));
+        }
+        
+        inline size_type erase(key_type const& key) {
+            auto it = find(key);
+            if (it == end()) {
+                return 0;
+            }
+            values_.erase(it);
+            return 1;
+        }
+        
+        inline iterator erase(const_iterator it) {
+            return values_.erase(it);
+        }
+        
+        // branchless binary search
+        inline size_type lower_bound_index(key_type const& key) const {
+            auto n = values_.size();
+            if (n == 0) {
+                return 0;
+            }
+            auto const* base = values_.data();
+            while (n > 1) {
+                auto const half = n / 2;
+                base = base[half].first < key ? base + half : base;
+                n -= half;
+            }
+            return static_cast<size_type>(base - values_.data()) + (base->first < key ? 1 : 0);
+        }
+    };
+}
@@ -14,6 +14,8 @@
  - http://www.json.org/
 ``` */
 
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <utility>
@@ -55,11 +57,210 @@ namespace bb {
     }
     
     
+    // Appends a JSON string literal of [ptr, ptr + size), quoted and escaped (UTF-8)
+    inline void append_json_string(std::string& json, char const* ptr, size_t const size) {
+        static char const* const hex = "0123456789abcdef";
+        json += '"';
+        for (size_t i = 0; i < size; ++i) {
+            auto const c = ptr[i];
+            switch (c) {
+                case '"':
+                    json += "\\\"";
+                    break;
+                case '\\':
+                    json += "\\\\";
+                    break;
+                case '\n':
+                    json += "\\n";
+                    break;
+                case '\r':
+                    json += "\\r";
+                    break;
+                case '\t':
+                    json += "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        json += "\\u00";
+                        json += hex[c >> 4];
+                        json += hex[c & 0x0F];
+                    }
+                    else {
+                        json += c;
+                    }
+                    break;
+            }
+        }
+        json += '"';
+    }
+    
+    // Returns a JSON string literal of str, quoted and escaped (str is UTF-8)
+    inline json_value_primitive_t make_json_string(std::string const& str) {
+        std::string json;
+        json.reserve(str.size() + 2);
+        append_json_string(json, str.data(), str.size());
+        return json;
+    }
+    
+    // Writes JSON in a single pass, without building json_value_t
+    // The output is the same as stringify(), compact or pretty
+    struct json_writer {
+        static size_t const flush_size = 64 * 1024;
+        
+        std::string buffer_;
+        std::FILE* file_ = nullptr;
+        int indent_level_ = 0;
+        int indent_size_ = -1; // < 0: compact
+        std::vector<bool> is_first_; // for each nesting container
+        bool is_after_key_ = false;
+        
+        // compact, into the buffer
+        json_writer() {
+        }
+        
+        // pretty, into the buffer
+        json_writer(int indent_level, int indent_size)
+        : indent_level_(indent_level), indent_size_(indent_size) {
+        }
+        
+        // compact, into the file
+        explicit json_writer(std::FILE* file)
+        : file_(file) {
+        }
+        
+        // pretty, into the file
+        json_writer(std::FILE* file, int indent_level, int indent_size)
+        : file_(file), indent_level_(indent_level), indent_size_(indent_size) {
+        }
+        
+        json_writer(json_writer const&) = delete;
+        json_writer const& operator=(json_writer const&) = delete;
+        
+        ~json_writer() {
+            flush();
+        }
+        
+        // Written JSON, if not into a file
+        inline std::string const& str() const {
+            return buffer_;
+        }
+        
+        inline std::string& str() {
+            return buffer_;
+        }
+        
+        inline void flush() {
+            if (file_ && !buffer_.empty()) {
+                std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+                buffer_.clear();
+            }
+        }
+        
+        inline void begin_object() {
+            begin_value();
+            buffer_ += '{';
+            is_first_.push_back(true);
+        }
+        
+        inline void end_object() {
+            end_container('}');
+        }
+        
+        inline void begin_array() {
+            begin_value();
+            buffer_ += '[';
+            is_first_.push_back(true);
+        }
+        
+        inline void end_array() {
+            end_container(']');
+        }
+        
+        // key: not escaped, same as json_value_object_t
+        inline void key(char const* key, size_t const size) {
+            separate();
+            buffer_ += '"';
+            buffer_.append(key, size);
+            buffer_ += indent_size_ < 0 ? "\":" : "\": ";
+            is_after_key_ = true;
+        }
+        
+        inline void key(std::string const& key) {
+            this->key(key.data(), key.size());
+        }
+        
+        // JSON text of a string, number, true or false (same as json_value_primitive_t)
+        inline void primitive(char const* ptr, size_t const size) {
+            begin_value();
+            buffer_.append(ptr, size);
+        }
+        
+        inline void primitive(std::string const& primitive) {
+            this->primitive(primitive.data(), primitive.size());
+        }
+        
+        inline void string(std::string const& str) {
+            begin_value();
+            append_json_string(buffer_, str.data(), str.size());
+        }
+        
+        inline void number(uint64_t const value) {
+            char buf[24];
+            auto const size = std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value));
+            primitive(buf, size);
+        }
+        
+        // Raw output buffer to append the current value in place (e.g. large strings), call begin_value() before
+        inline std::string& buffer() {
+            return buffer_;
+        }
+        
+        inline void begin_value() {
+            if (is_after_key_) {
+                is_after_key_ = false;
+                return;
+            }
+            if (!is_first_.empty()) {
+                separate();
+            }
+        }
+        
+        inline void separate() {
+            if (!is_first_.back()) {
+                buffer_ += ',';
+            }
+            is_first_.back() = false;
+            if (indent_size_ >= 0) {
+                buffer_ += '\n';
+                buffer_.append((indent_level_ + is_first_.size()) * indent_size_, ' ');
+            }
+        }
+        
+        inline void end_container(char const c) {
+            is_first_.pop_back();
+            if (indent_size_ >= 0) {
+                buffer_ += '\n';
+                buffer_.append((indent_level_ + is_first_.size()) * indent_size_, ' ');
+            }
+            buffer_ += c;
+            if (buffer_.size() >= flush_size) {
+                flush();
+            }
+        }
+    };
+    
+    
     template <class _T>
     json_value_object_t make_json(_T const&);
     
+    // Writes value as make_json(value) does, without building json_value_t
+    template <class _T>
+    void write_json(json_writer& writer, _T const&);
+    
     std::string stringify(json_value_object_t const& json, int indent_level, int indent_size);
     std::string stringify(json_value_array_t const& array, int indent_level, int indent_size);
+    std::string stringify(json_value_object_t const& json);
+    std::string stringify(json_value_array_t const& array);
     
     std::string stringify(json_value_object_t const& json, int indent_level, int indent_size) {
         std::stringstream ss;
@@ -122,4 +323,56 @@ namespace bb {
         ss << std::setw(indent_level * indent_size) << "" << "]";
         return ss.str();
     }
+    
+    // compact, in one line (e.g. for NDJSON)
+    std::string stringify(json_value_object_t const& json) {
+        std::string str = "{";
+        bool is_first = true;
+        for (auto const& pair: json) {
+            if (!is_first) {
+                str += ",";
+            }
+            str += "\"" + pair.first + "\":";
+            
+            auto const& value = pair.second;
+            switch (value.type()) {
+                case json_value_type_t::primitive:
+                    str += value.primitive_;
+                    break;
+                case json_value_type_t::array:
+                    str += stringify(value.array_);
+                    break;
+                case json_value_type_t::object:
+                    str += stringify(value.object_);
+                    break;
+            }
+            is_first = false;
+        }
+        str += "}";
+        return str;
+    }
+    
+    std::string stringify(json_value_array_t const& array) {
+        std::string str = "[";
+        bool is_first = true;
+        for (auto const& value: array) {
+            if (!is_first) {
+                str += ",";
+            }
+            switch (value.type()) {
+                case json_value_type_t::primitive:
+                    str += value.primitive_;
+                    break;
+                case json_value_type_t::array:
+                    str += stringify(value.array_);
+                    break;
+                case json_value_type_t::object:
+                    str += stringify(value.object_);
+                    break;
+            }
+            is_first = false;
+        }
+        str += "]";
+        return str;
+    }
 }
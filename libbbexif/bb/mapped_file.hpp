@@ -0,0 +1,132 @@
+//
+//  mapped_file.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BB_MAPPED_FILE_AVAILABLE 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define BB_MAPPED_FILE_AVAILABLE 0
+#endif
+
+namespace bb {
+    // read-only memory mapping of a whole regular file
+    struct mapped_file {
+        uint8_t const* ptr_ = nullptr;
+        size_t size_ = 0;
+        
+        mapped_file() noexcept {
+        }
+        
+        mapped_file(mapped_file const&) = delete;
+        mapped_file const& operator=(mapped_file const&) = delete;
+        
+        mapped_file(mapped_file&& obj) noexcept
+        : ptr_(obj.ptr_), size_(obj.size_) {
+            obj.ptr_ = nullptr;
+            obj.size_ = 0;
+        }
+        
+        mapped_file const& operator=(mapped_file&& obj) noexcept {
+            close();
+            ptr_ = obj.ptr_;
+            size_ = obj.size_;
+            obj.ptr_ = nullptr;
+            obj.size_ = 0;
+            return *this;
+        }
+        
+        ~mapped_file() {
+            close();
+        }
+        
+        // Returns false if the file can not be mapped (e.g. not found, pipe, empty), then nothing is mapped
+        inline bool open(char const* filepath) noexcept {
+            close();
+#if BB_MAPPED_FILE_AVAILABLE
+            int fd = ::open(filepath, O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            auto const result = open(fd);
+            // The mapping is kept after closing the descriptor
+            ::close(fd);
+            return result;
+#else
+            (void)filepath;
+            return false;
+#endif
+        }
+        
+        // fd: opened by the caller, who may close it after this returns
+        inline bool open(int const fd) noexcept {
+            close();
+#if BB_MAPPED_FILE_AVAILABLE
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+                return false;
+            }
+            auto size = static_cast<size_t>(st.st_size);
+            void* ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr == MAP_FAILED) {
+                return false;
+            }
+            ptr_ = static_cast<uint8_t const*>(ptr);
+            size_ = size;
+            return true;
+#else
+            (void)fd;
+            return false;
+#endif
+        }
+        
+        inline void close() noexcept {
+#if BB_MAPPED_FILE_AVAILABLE
+            if (ptr_) {
+                ::munmap(const_cast<uint8_t*>(ptr_), size_);
+            }
+#endif
+            ptr_ = nullptr;
+            size_ = 0;
+        }
+        
+        inline bool is_open() const noexcept {
+            return ptr_ != nullptr;
+        }
+        
+        inline uint8_t const* ptr() const noexcept {
+            return ptr_;
+        }
+        
+        inline size_t size() const noexcept {
+            return size_;
+        }
+
+#if BB_MAPPED_FILE_AVAILABLE
+        // advice: e.g. MADV_RANDOM, MADV_WILLNEED; hints only, so errors are ignored
+        inline void advise(size_t const offset, size_t const length, int const advice) const noexcept {
+            if (!ptr_ || offset >= size_) {
+                return;
+            }
+            // madvise requires a page aligned address
+            static size_t const page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            auto const aligned_offset = offset - offset % page_size;
+            auto const aligned_length = (length < size_ - offset ? length : size_ - offset) + (offset - aligned_offset);
+            ::madvise(const_cast<uint8_t*>(ptr_) + aligned_offset, aligned_length, advice);
+        }
+#endif
+    };
+}
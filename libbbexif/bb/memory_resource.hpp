@@ -0,0 +1,177 @@
+//
+//  memory_resource.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ std::pmr (C++17) like memory resources:
+ - new_delete_resource(): the default, uses ::operator new and ::operator delete
+ - monotonic_buffer_resource: allocates from chunks, deallocation is no-op, release() frees all at once
+ - polymorphic_allocator<T>: allocator for containers, refers to a memory_resource
+``` */
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace bb {
+    struct memory_resource {
+        virtual ~memory_resource() {
+        }
+        
+        virtual void* allocate(size_t const size, size_t const alignment) = 0;
+        virtual void deallocate(void* ptr, size_t const size, size_t const alignment) noexcept = 0;
+        
+        virtual bool is_equal(memory_resource const& other) const noexcept {
+            return this == &other;
+        }
+    };
+    
+    struct new_delete_memory_resource : memory_resource {
+        void* allocate(size_t const size, size_t const) override {
+            return ::operator new(size);
+        }
+        
+        void deallocate(void* ptr, size_t const, size_t const) noexcept override {
+            ::operator delete(ptr);
+        }
+    };
+    
+    inline memory_resource* new_delete_resource() noexcept {
+        static new_delete_memory_resource resource;
+        return &resource;
+    }
+    
+    // not thread-safe, use one for each thread (or each parse)
+    struct monotonic_buffer_resource : memory_resource {
+        struct chunk_t {
+            chunk_t* next;
+            size_t size;
+        };
+        
+        static size_t const max_chunk_size = static_cast<size_t>(-1) / 2;
+        
+        memory_resource* upstream_;
+        uint8_t* initial_buffer_ = nullptr;
+        size_t initial_size_ = 0;
+        size_t initial_chunk_size_; // restored by release()
+        size_t next_chunk_size_;
+        chunk_t* chunks_ = nullptr;
+        uint8_t* current_ = nullptr;
+        size_t available_ = 0;
+        
+        explicit monotonic_buffer_resource(size_t const initial_chunk_size = 4096, memory_resource* upstream = new_delete_resource()) noexcept
+        : upstream_(upstream), initial_chunk_size_(initial_chunk_size > 0 ? initial_chunk_size : 4096), next_chunk_size_(initial_chunk_size_) {
+        }
+        
+        // buffer: used at first (e.g. on the stack), must outlive this
+        monotonic_buffer_resource(void* buffer, size_t const size, memory_resource* upstream = new_delete_resource()) noexcept
+        : upstream_(upstream), initial_buffer_(static_cast<uint8_t*>(buffer)), initial_size_(size), initial_chunk_size_(size > 0 ? size : 4096), next_chunk_size_(initial_chunk_size_), current_(initial_buffer_), available_(size) {
+        }
+        
+        monotonic_buffer_resource(monotonic_buffer_resource const&) = delete;
+        monotonic_buffer_resource const& operator=(monotonic_buffer_resource const&) = delete;
+        
+        ~monotonic_buffer_resource() {
+            release();
+        }
+        
+        // Frees all allocated memory at once, even if it has not been deallocated
+        inline void release() noexcept {
+            while (chunks_) {
+                auto next = chunks_->next;
+                upstream_->deallocate(chunks_, chunks_->size, alignof(std::max_align_t));
+                chunks_ = next;
+            }
+            current_ = initial_buffer_;
+            available_ = initial_size_;
+            // as std::pmr, otherwise chunks would grow on every cycle of allocations and release()
+            next_chunk_size_ = initial_chunk_size_;
+        }
+        
+        void* allocate(size_t const size, size_t const alignment) override {
+            auto padding = (alignment - reinterpret_cast<uintptr_t>(current_) % alignment) % alignment;
+            if (!current_ || available_ < size + padding) {
+                // header, padding and the requested size
+                auto chunk_size = next_chunk_size_;
+                if (size > max_chunk_size - sizeof(chunk_t) - alignment) {
+                    throw std::bad_alloc();
+                }
+                auto const required_size = sizeof(chunk_t) + alignment + size;
+                while (chunk_size < required_size) {
+                    chunk_size = chunk_size <= max_chunk_size / 2 ? chunk_size * 2 : max_chunk_size;
+                }
+                auto chunk = static_cast<chunk_t*>(upstream_->allocate(chunk_size, alignof(std::max_align_t)));
+                chunk->next = chunks_;
+                chunk->size = chunk_size;
+                chunks_ = chunk;
+                next_chunk_size_ = chunk_size <= max_chunk_size / 2 ? chunk_size * 2 : max_chunk_size;
+                current_ = reinterpret_cast<uint8_t*>(chunk) + sizeof(chunk_t);
+                available_ = chunk_size - sizeof(chunk_t);
+                padding = (alignment - reinterpret_cast<uintptr_t>(current_) % alignment) % alignment;
+            }
+            auto ptr = current_ + padding;
+            current_ += padding + size;
+            available_ -= padding + size;
+            return ptr;
+        }
+        
+        void deallocate(void*, size_t const, size_t const) noexcept override {
+            // no-op, see release()
+        }
+    };
+    
+    template <typename _T>
+    struct polymorphic_allocator {
+        using value_type = _T;
+        
+        memory_resource* resource_;
+        
+        polymorphic_allocator() noexcept
+        : resource_(new_delete_resource()) {
+        }
+        
+        polymorphic_allocator(memory_resource* resource) noexcept
+        : resource_(resource) {
+        }
+        
+        template <typename _U>
+        polymorphic_allocator(polymorphic_allocator<_U> const& obj) noexcept
+        : resource_(obj.resource()) {
+        }
+        
+        inline memory_resource* resource() const noexcept {
+            return resource_;
+        }
+        
+        inline _T* allocate(size_t const n) {
+            return static_cast<_T*>(resource_->allocate(n * sizeof(_T), alignof(_T)));
+        }
+        
+        inline void deallocate(_T* ptr, size_t const n) noexcept {
+            resource_->deallocate(ptr, n * sizeof(_T), alignof(_T));
+        }
+        
+        // Copies of containers do not refer to the memory resource, so that they may outlive it (same as std::pmr)
+        inline polymorphic_allocator select_on_container_copy_construction() const noexcept {
+            return polymorphic_allocator();
+        }
+    };
+    
+    template <typename _T, typename _U>
+    inline bool operator==(polymorphic_allocator<_T> const& lhs, polymorphic_allocator<_U> const& rhs) noexcept {
+        return lhs.resource() == rhs.resource() || lhs.resource()->is_equal(*rhs.resource());
+    }
+    
+    template <typename _T, typename _U>
+    inline bool operator!=(polymorphic_allocator<_T> const& lhs, polymorphic_allocator<_U> const& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+}
@@ -0,0 +1,90 @@
+//
+//  optional.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ A minimal std::optional (C++17) for C++14, same restrictions as bb::expected:
+ - _T must be default constructible, the value is left default constructed if empty
+ - accessors do not check nor throw, check has_value() at first
+``` */
+
+#include <utility>
+
+namespace bb {
+    struct nullopt_t {
+        explicit constexpr nullopt_t(int) {
+        }
+    };
+    
+    constexpr nullopt_t nullopt{0};
+    
+    template <typename _T>
+    struct optional {
+        bool has_value_;
+        _T value_;
+        
+        constexpr optional() noexcept
+        : has_value_(false), value_() {
+        }
+        
+        constexpr optional(nullopt_t) noexcept
+        : has_value_(false), value_() {
+        }
+        
+        constexpr optional(_T const& value)
+        : has_value_(true), value_(value) {
+        }
+        
+        constexpr optional(_T&& value)
+        : has_value_(true), value_(std::move(value)) {
+        }
+        
+        constexpr bool has_value() const noexcept {
+            return has_value_;
+        }
+        
+        constexpr explicit operator bool() const noexcept {
+            return has_value_;
+        }
+        
+        inline _T& value() & noexcept {
+            return value_;
+        }
+        
+        constexpr _T const& value() const& noexcept {
+            return value_;
+        }
+        
+        inline _T&& value() && noexcept {
+            return std::move(value_);
+        }
+        
+        inline _T& operator*() & noexcept {
+            return value_;
+        }
+        
+        constexpr _T const& operator*() const& noexcept {
+            return value_;
+        }
+        
+        inline _T* operator->() noexcept {
+            return &value_;
+        }
+        
+        constexpr _T const* operator->() const noexcept {
+            return &value_;
+        }
+        
+        template <typename _U>
+        constexpr _T value_or(_U&& default_value) const& {
+            return has_value_ ? value_ : static_cast<_T>(std::forward<_U>(default_value));
+        }
+    };
+}
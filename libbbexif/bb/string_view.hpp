@@ -0,0 +1,58 @@
+//
+//  string_view.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ A minimal std::string_view (C++17) for C++14, refers to [data(), data() + size()) without owning it
+``` */
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace bb {
+    struct string_view {
+        char const* data_ = nullptr;
+        size_t size_ = 0;
+        
+        constexpr string_view() noexcept = default;
+        
+        constexpr string_view(char const* data, size_t const size) noexcept
+        : data_(data), size_(size) {
+        }
+        
+        string_view(char const* str) noexcept
+        : data_(str), size_(std::strlen(str)) {
+        }
+        
+        string_view(std::string const& str) noexcept
+        : data_(str.data()), size_(str.size()) {
+        }
+        
+        constexpr char const* data() const noexcept { return data_; }
+        constexpr size_t size() const noexcept { return size_; }
+        constexpr bool empty() const noexcept { return size_ == 0; }
+        constexpr char const* begin() const noexcept { return data_; }
+        constexpr char const* end() const noexcept { return data_ + size_; }
+        constexpr char operator[](size_t const index) const noexcept { return data_[index]; }
+        
+        inline std::string to_string() const {
+            return std::string(data_, size_);
+        }
+    };
+    
+    inline bool operator==(string_view const& lhs, string_view const& rhs) noexcept {
+        return lhs.size() == rhs.size() && (lhs.size() == 0 || std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+    }
+    
+    inline bool operator!=(string_view const& lhs, string_view const& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+}
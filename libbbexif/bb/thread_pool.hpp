@@ -0,0 +1,157 @@
+//
+//  thread_pool.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bb {
+    // work-stealing thread pool: each worker has its own queue, and steals tasks from others when it is empty
+    struct thread_pool {
+        struct worker_queue_t {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+        
+        std::vector<std::unique_ptr<worker_queue_t>> queues_;
+        std::vector<std::thread> threads_;
+        std::mutex mutex_;
+        std::condition_variable task_cv_;
+        std::condition_variable idle_cv_;
+        size_t queued_ = 0; // in queues
+        size_t pending_ = 0; // in queues or running
+        size_t next_queue_ = 0;
+        bool is_stopping_ = false;
+        
+        // number_of_threads: 0 means std::thread::hardware_concurrency()
+        explicit thread_pool(size_t number_of_threads = 0) {
+            if (number_of_threads == 0) {
+                number_of_threads = std::thread::hardware_concurrency();
+            }
+            if (number_of_threads == 0) {
+                number_of_threads = 1;
+            }
+            for (size_t i = 0; i < number_of_threads; ++i) {
+                queues_.emplace_back(new worker_queue_t());
+            }
+            for (size_t i = 0; i < number_of_threads; ++i) {
+                threads_.emplace_back([this, i]() {
+                    run(i);
+                });
+            }
+        }
+        
+        thread_pool(thread_pool const&) = delete;
+        thread_pool const& operator=(thread_pool const&) = delete;
+        
+        // Finishes all submitted tasks before joining threads
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                is_stopping_ = true;
+            }
+            task_cv_.notify_all();
+            for (auto& thread: threads_) {
+                thread.join();
+            }
+        }
+        
+        inline size_t size() const {
+            return threads_.size();
+        }
+        
+        // task: should not throw, exceptions are ignored
+        inline void submit(std::function<void()> task) {
+            size_t index;
+            {
+                // counted before the task is published, so a worker finishing it does not decrement them below zero
+                std::lock_guard<std::mutex> lock(mutex_);
+                index = next_queue_++ % queues_.size();
+                ++queued_;
+                ++pending_;
+            }
+            {
+                auto& queue = *queues_[index];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+            task_cv_.notify_one();
+        }
+        
+        // Waits until all submitted tasks are finished
+        inline void wait() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            idle_cv_.wait(lock, [this]() {
+                return pending_ == 0;
+            });
+        }
+        
+        // own queue in FIFO order, others' queues from the back
+        inline bool try_pop(size_t const index, std::function<void()>& task) {
+            for (size_t i = 0; i < queues_.size(); ++i) {
+                auto& queue = *queues_[(index + i) % queues_.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty()) {
+                    continue;
+                }
+                if (i == 0) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                else {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                return true;
+            }
+            return false;
+        }
+        
+        inline void run(size_t const index) {
+            for (;;) {
+                std::function<void()> task;
+                if (try_pop(index, task)) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        --queued_;
+                    }
+                    try {
+                        task();
+                    }
+                    catch (...) {
+                    }
+                    bool is_idle;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        is_idle = --pending_ == 0;
+                    }
+                    if (is_idle) {
+                        idle_cv_.notify_all();
+                    }
+                    continue;
+                }
+                
+                std::unique_lock<std::mutex> lock(mutex_);
+                task_cv_.wait(lock, [this]() {
+                    return is_stopping_ || queued_ > 0;
+                });
+                if (is_stopping_ && queued_ == 0) {
+                    return;
+                }
+            }
+        }
+    };
+}
@@ -19,12 +19,14 @@
 
 #include <type_traits>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <stdexcept>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
-#include <map>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -33,6 +35,12 @@
 #include "bb/binary_reader.hpp"
 #include "bb/json.hpp"
 #include "bb/debug.hpp"
+#include "bb/mapped_file.hpp"
+#include "bb/file_chunk_reader.hpp"
+#include "bb/flat_map.hpp"
+#include "bb/memory_resource.hpp"
+#include "bb/encoding.hpp"
+#include "bb/expected.hpp"
 
 namespace bbexif {
     // usage: e.g. template<typename _T, enable_if_type<_T, syd::is_pointer> = nullptr>
@@ -88,45 +96,444 @@ namespace bbexif {
         inline uint32_t offset() const { return value_or_offset_; }
     };
     
+    // allocated from bb::new_delete_resource() by default, see make_exif(exif_view_t const&, bb::memory_resource*)
+    using data_t = std::vector<char, bb::polymorphic_allocator<char>>;
+    
     struct ifd_value_t {
         ifd_tag_type_t type_;
         size_t value_count_;
-        std::vector<char> data_;
+        data_t data_;
         
         inline ifd_tag_type_t type() const { return type_; }
         inline size_t value_count() const { return value_count_; }
-        inline std::vector<char> const& data() const { return data_; }
+        inline data_t const& data() const { return data_; }
         template <typename _T, enable_if_type<_T, std::is_pointer> = nullptr>
         inline _T value_ptr() const { return reinterpret_cast<_T>(data_.data()); }
         
-        inline std::vector<char>& data() { return data_; }
+        inline data_t& data() { return data_; }
         template <typename _T, enable_if_type<_T, std::is_pointer> = nullptr>
         inline _T value_ptr() { return reinterpret_cast<_T>(data_.data()); }
     };
     
-    using ifd_t = std::map<ifd_tag_id_t, ifd_value_t>;
+    // sorted by ifd_tag_id_t like std::map
+    using ifd_t = bb::flat_map<ifd_tag_id_t, ifd_value_t>;
+    
+    // thumbnail (JPEG) in the source, to read it on demand (e.g. sendfile() from the file)
+    struct thumbnail_location_t {
+        uint64_t offset; // from the beginning of the source, see read functions
+        size_t size; // 0 if there is no thumbnail
+    };
     
     struct exif_t {
         std::vector<ifd_t> ifds;
         ifd_t exif;
         ifd_t gps;
-        std::vector<char> thumbnail;
+        data_t thumbnail; // empty if read_options_t::copies_thumbnail is false
+        thumbnail_location_t thumbnail_location;
+        ifd_t interop; // Interoperability IFD (0xA005 in the Exif IFD)
+        std::vector<ifd_t> sub_ifds; // SubIFDs (0x014A in the 0th IFD), e.g. of DNG
+        ifd_t maker_note; // MakerNote (0x927C in the Exif IFD) if it is an IFD, see traversal_budget_t
+    };
+    
+    struct ifd_tag_type_info_t {
+        bool is_supported;
+        ifd_tag_type_t type;
+        uint16_t code; // recorded in files
+        size_t size;
+    };
+    
+    // indexed by the type code recorded in files
+    constexpr ifd_tag_type_info_t ifd_tag_type_info_table[] = {
+        { false, ifd_tag_type_t::undefined, 0, 0 },
+        { true, ifd_tag_type_t::byte, 1, sizeof(ifd_tag_type_byte_t) },
+        { true, ifd_tag_type_t::ascii, 2, sizeof(ifd_tag_type_ascii_t) },
+        { true, ifd_tag_type_t::short_, 3, sizeof(ifd_tag_type_short_t) },
+        { true, ifd_tag_type_t::long_, 4, sizeof(ifd_tag_type_long_t) },
+        { true, ifd_tag_type_t::rational, 5, sizeof(ifd_tag_type_rational_t) },
+        { false, ifd_tag_type_t::undefined, 6, 0 }, // SBYTE (TIFF 6.0)
+        { true, ifd_tag_type_t::undefined, 7, sizeof(ifd_tag_type_undefined_t) },
+        { false, ifd_tag_type_t::undefined, 8, 0 }, // SSHORT (TIFF 6.0)
+        { true, ifd_tag_type_t::slong, 9, sizeof(ifd_tag_type_slong_t) },
+        { true, ifd_tag_type_t::srational, 10, sizeof(ifd_tag_type_srational_t) },
+    };
+    
+    // indexed by ifd_tag_type_t
+    constexpr uint16_t ifd_tag_type_code_table[] = { 1, 2, 3, 4, 5, 7, 9, 10 };
+    
+    constexpr ifd_tag_type_info_t ifd_tag_type_info(uint16_t const code) {
+        return code < sizeof(ifd_tag_type_info_table) / sizeof(ifd_tag_type_info_table[0]) ? ifd_tag_type_info_table[code] : ifd_tag_type_info_table[0];
+    }
+    
+    constexpr ifd_tag_type_info_t ifd_tag_type_info(ifd_tag_type_t const type) {
+        return ifd_tag_type_info_table[ifd_tag_type_code_table[static_cast<size_t>(type)]];
+    }
+    
+    constexpr size_t ifd_tag_type_size(ifd_tag_type_t const type) {
+        return ifd_tag_type_info(type).size;
+    }
+    
+    static_assert(ifd_tag_type_info(ifd_tag_type_t::srational).code == 10, "ifd_tag_type_code_table must be in the order of ifd_tag_type_t");
+    static_assert(!ifd_tag_type_info(uint16_t(11)).is_supported, "FLOAT is not supported");
+    
+    // non-owning views: refer to the source buffer, values are converted to the native byte order on demand
+    
+    struct ifd_entry_t {
+        ifd_tag_id_t id_;
+        ifd_tag_type_t type_;
+        uint32_t count_;
+        uint32_t offset_; // offset to value(s) from the TIFF header, even if value(s) are recorded in the IFD entry
+        
+        inline ifd_tag_id_t id() const { return id_; }
+        inline ifd_tag_type_t type() const { return type_; }
+        inline uint32_t count() const { return count_; }
+        inline uint32_t offset() const { return offset_; }
+    };
+    
+    struct ifd_value_view_t {
+        ifd_tag_type_t type_;
+        size_t value_count_;
+        uint8_t const* data_;
+        size_t size_;
+        bb::byte_order_t byte_order_;
+        
+        inline ifd_tag_type_t type() const { return type_; }
+        inline size_t value_count() const { return value_count_; }
+        inline bb::byte_order_t byte_order() const { return byte_order_; }
+        // raw data recorded in byte_order()
+        inline uint8_t const* data() const { return data_; }
+        inline size_t size() const { return size_; }
+        
+        template <typename _T>
+        inline _T value(size_t const index = 0) const {
+            auto mr = bb::memory_reader(data_, size_);
+            return bb::peek<_T>(mr, sizeof(_T) * index, byte_order_);
+        }
+        
+        // dst: size() bytes, receives value(s) converted to the native byte order
+        inline void copy_to(char* dst) const {
+            auto mr = bb::memory_reader(data_, size_);
+            auto const type_size = ifd_tag_type_size(type_);
+            if (type_size == 1) {
+                mr.peek(0, reinterpret_cast<uint8_t*>(dst), size_);
+                return;
+            }
+            // rational and srational are pairs of long
+            auto const word_size = type_size == 8 ? 4 : type_size;
+            switch (word_size) {
+                case 2:
+                    bb::peek_array(mr, 0, reinterpret_cast<uint16_t*>(dst), size_ / 2, byte_order_);
+                    break;
+                case 4:
+                    bb::peek_array(mr, 0, reinterpret_cast<uint32_t*>(dst), size_ / 4, byte_order_);
+                    break;
+            }
+        }
+    };
+    
+    struct ifd_view_t {
+        uint8_t const* ptr_ = nullptr; // TIFF header
+        size_t size_ = 0;
+        bb::byte_order_t byte_order_ = bb::byte_order_t::native;
+        std::vector<ifd_entry_t> entries_; // sorted by id
+        
+        inline bb::byte_order_t byte_order() const { return byte_order_; }
+        inline std::vector<ifd_entry_t> const& entries() const { return entries_; }
+        inline size_t size() const { return entries_.size(); }
+        inline bool empty() const { return entries_.empty(); }
+        
+        inline ifd_entry_t const* find(ifd_tag_id_t const id) const {
+            auto it = std::lower_bound(entries_.begin(), entries_.end(), id, [](ifd_entry_t const& entry, ifd_tag_id_t const id) {
+                return entry.id() < id;
+            });
+            if (it == entries_.end() || it->id() != id) {
+                return nullptr;
+            }
+            return &*it;
+        }
+        
+        inline size_t count(ifd_tag_id_t const id) const {
+            return find(id) ? 1 : 0;
+        }
+        
+        inline ifd_value_view_t at(ifd_tag_id_t const id) const {
+            auto entry = find(id);
+            if (!entry) {
+                throw std::out_of_range(bb_trace_message("IFD tag not found: id=0x%04X", id));
+            }
+            return value(*entry);
+        }
+        
+        inline ifd_value_view_t value(ifd_entry_t const& entry) const {
+            auto const size = entry.count() * ifd_tag_type_size(entry.type());
+            return {entry.type(), entry.count(), ptr_ + entry.offset(), size, byte_order_};
+        }
+    };
+    
+    struct exif_view_t {
+        bb::byte_order_t byte_order;
+        std::vector<ifd_view_t> ifds;
+        ifd_view_t exif;
+        ifd_view_t gps;
+        uint8_t const* thumbnail_data;
+        size_t thumbnail_size;
+        ifd_view_t interop;
+        std::vector<ifd_view_t> sub_ifds;
+        ifd_view_t maker_note;
+    };
+    
+    // Bounds of traversing IFDs in a parse, against malformed or hostile files (e.g. looping offsets)
+    // IFDs over the budget are skipped with diagnostic_code_t::budget_exceeded
+    // The MakerNote is read only if it is an IFD with offsets from the TIFF header (e.g. Canon), otherwise it is skipped silently
+    struct traversal_budget_t {
+        size_t max_ifds = 64;
+        size_t max_bytes = 16 * 1024 * 1024; // of IFDs and their values, which are copied by make_exif()
     };
 }
 
+#ifndef BBEXIF_DIAGNOSTICS
+#define BBEXIF_DIAGNOSTICS 1 // 0: diagnostics are not reported at all
+#endif
+
+namespace bbexif {
+    enum class diagnostic_code_t {
+        unsupported_type, // the tag is skipped
+        unsupported_inline_value, // 8 bytes type value in the entry (i.e. count is 0), the tag is skipped
+        value_out_of_range, // the offset to the value points out of the TIFF data, the tag is skipped
+        ifd_visited, // the pointer tag points to an IFD already read (e.g. a loop), the IFD is skipped
+        budget_exceeded, // see traversal_budget_t, the IFD pointed by the tag is skipped
+    };
+    
+    static size_t const number_of_diagnostic_codes = 5;
+    
+    struct diagnostic_t {
+        diagnostic_code_t code;
+        ifd_tag_id_t id;
+        uint16_t type; // recorded in the file
+        uint32_t count;
+        uint32_t linked_ifd_offset; // from the TIFF header if the skipped IFD is linked from the previous IFD (id, type and count are 0), otherwise 0
+    };
+    
+    // Receives diagnostics while parsing on the thread where it is installed, see scoped_diagnostics_sink_t
+    // Counts diagnostics for each code, override on_report() to handle them (e.g. logging)
+    struct diagnostics_sink_t {
+        size_t counts_[number_of_diagnostic_codes] = {};
+        
+        virtual ~diagnostics_sink_t() {
+        }
+        
+        inline size_t count(diagnostic_code_t const code) const {
+            return counts_[static_cast<size_t>(code)];
+        }
+        
+        inline size_t total_count() const {
+            size_t total = 0;
+            for (auto const count: counts_) {
+                total += count;
+            }
+            return total;
+        }
+        
+        inline void reset() {
+            for (auto& count: counts_) {
+                count = 0;
+            }
+        }
+        
+        inline void report(diagnostic_t const& diagnostic) {
+            ++counts_[static_cast<size_t>(diagnostic.code)];
+            on_report(diagnostic);
+        }
+        
+        virtual void on_report(diagnostic_t const&) {
+        }
+    };
+    
+    inline diagnostics_sink_t*& current_diagnostics_sink() {
+        thread_local diagnostics_sink_t* sink = nullptr;
+        return sink;
+    }
+    
+    // Installs the sink on this thread while alive (nullptr to suppress), and restores the previous one
+    struct scoped_diagnostics_sink_t {
+        diagnostics_sink_t* previous_;
+        
+        explicit scoped_diagnostics_sink_t(diagnostics_sink_t* sink)
+        : previous_(current_diagnostics_sink()) {
+            current_diagnostics_sink() = sink;
+        }
+        
+        scoped_diagnostics_sink_t(scoped_diagnostics_sink_t const&) = delete;
+        scoped_diagnostics_sink_t const& operator=(scoped_diagnostics_sink_t const&) = delete;
+        
+        ~scoped_diagnostics_sink_t() {
+            current_diagnostics_sink() = previous_;
+        }
+    };
+    
+    // Does nothing without a sink on this thread
+    inline void report_diagnostic(diagnostic_code_t const code, ifd_tag_id_t const id, uint16_t const type, uint32_t const count) {
+#if BBEXIF_DIAGNOSTICS
+        if (auto sink = current_diagnostics_sink()) {
+            sink->report({code, id, type, count, 0});
+        }
+#endif
+    }
+    
+    // For an IFD linked from the previous IFD, which has no pointer tag
+    inline void report_linked_ifd_diagnostic(diagnostic_code_t const code, uint32_t const offset) {
+#if BBEXIF_DIAGNOSTICS
+        if (auto sink = current_diagnostics_sink()) {
+            sink->report({code, 0, 0, 0, offset});
+        }
+#endif
+    }
+    
+    // e.g. for logging, formatted only when called
+    inline std::string describe(diagnostic_t const& diagnostic) {
+        static char const* const reasons[number_of_diagnostic_codes] = {
+            "not supported type",
+            "not supported inline value",
+            "value out of range",
+            "IFD already visited",
+            "traversal budget exceeded",
+        };
+        char buf[128];
+        if (diagnostic.linked_ifd_offset != 0) {
+            std::snprintf(buf, sizeof(buf), "Skipped reading the linked IFD (%s): offset=0x%08X", reasons[static_cast<size_t>(diagnostic.code)], diagnostic.linked_ifd_offset);
+        }
+        else {
+            std::snprintf(buf, sizeof(buf), "Skipped reading the IFD tag (%s): id=0x%04X, type=%d, count=%u", reasons[static_cast<size_t>(diagnostic.code)], diagnostic.id, diagnostic.type, diagnostic.count);
+        }
+        return buf;
+    }
+    
+    enum class error_code_t {
+        none,
+        file_not_opened,
+        not_jpeg, // SOI marker not found
+        invalid_marker,
+        invalid_segment_length,
+        truncated, // the data ends in a segment
+        app1_not_found, // SOS or EOI before the Exif APP1 segment
+        exif_not_found, // the Exif identifier code or the TIFF byte order not found
+        unsupported_version,
+        invalid_ifd, // an IFD or an offset to it points out of the TIFF data
+    };
+    
+    inline char const* describe(error_code_t const code) {
+        switch (code) {
+            case error_code_t::none:
+                return "No error";
+            case error_code_t::file_not_opened:
+                return "Unable to open the file";
+            case error_code_t::not_jpeg:
+                return "JPEG SOI marker not found";
+            case error_code_t::invalid_marker:
+                return "JFIF marker not found";
+            case error_code_t::invalid_segment_length:
+                return "Invalid JFIF segment length";
+            case error_code_t::truncated:
+                return "Unable to read a exif";
+            case error_code_t::app1_not_found:
+                return "APP1 segment not found";
+            case error_code_t::exif_not_found:
+                return "Exif not found";
+            case error_code_t::unsupported_version:
+                return "Unsupported Exif version";
+            case error_code_t::invalid_ifd:
+                return "Unable to read Exif";
+        }
+        return "Unknown error";
+    }
+    
+    // Returned by try_read_exif() and friends instead of throwing
+    struct error_t {
+        error_code_t code_ = error_code_t::none;
+        uint64_t offset_ = 0; // where the error is detected, from the beginning of the input (e.g. the file)
+        
+        inline error_code_t code() const {
+            return code_;
+        }
+        
+        inline uint64_t offset() const {
+            return offset_;
+        }
+        
+        // formatted only when called
+        inline std::string message() const {
+            char buf[128];
+            std::snprintf(buf, sizeof(buf), "%s (at offset %llu)", describe(code_), static_cast<unsigned long long>(offset_));
+            return buf;
+        }
+    };
+    
+    template <typename _T>
+    using result_t = bb::expected<_T, error_t>;
+    
+    inline bb::unexpected<error_t> make_error(error_code_t const code, uint64_t const offset) {
+        return {{code, offset}};
+    }
+    
+    // The throwing API is layered on the try_ one with these
+    [[noreturn]] inline void throw_error(error_t const& error) {
+        throw std::runtime_error(bb_trace_message("%s", describe(error.code())));
+    }
+    
+    [[noreturn]] inline void throw_error(error_t const& error, std::string const& filepath) {
+        if (error.code() == error_code_t::file_not_opened) {
+            throw std::runtime_error(bb_trace_message("%s: %s", describe(error.code()), filepath.c_str()));
+        }
+        throw_error(error);
+    }
+    
+    template <typename _T>
+    inline _T value_or_throw(result_t<_T>&& result) {
+        if (!result) {
+            throw_error(result.error());
+        }
+        return std::move(result).value();
+    }
+    
+    template <typename _T>
+    inline _T value_or_throw(result_t<_T>&& result, std::string const& filepath) {
+        if (!result) {
+            throw_error(result.error(), filepath);
+        }
+        return std::move(result).value();
+    }
+}
+
 // extension bb::binary_reader
 namespace bb {
+    // Returns error_code_t::none if succeeded
+    // Fill bytes (0xFF) before the marker code must be skipped by the caller
     template <typename _Readable>
-    inline bbexif::jfif_segment_header_t read_jfif_segment_header(_Readable& r) {
+    inline bbexif::error_code_t try_read_jfif_segment_header(_Readable& r, bbexif::jfif_segment_header_t& header) {
         auto marker_code = read<uint16_t>(r, byte_order_t::big_endian);
         if (marker_code == 0xFFD8 || marker_code == 0xFFD9) {
-            return {marker_code, 0};
+            header = {marker_code, 0};
+            return bbexif::error_code_t::none;
+        }
+        else if ((marker_code & 0xFF00) != 0xFF00 || marker_code == 0xFF00) {
+            return bbexif::error_code_t::invalid_marker;
+        }
+        auto segment_length = read<uint16_t>(r, byte_order_t::big_endian);
+        if (segment_length < 2) {
+            // includes the length field itself
+            return bbexif::error_code_t::invalid_segment_length;
         }
-        else if (marker_code && 0xFF00 != 0xFF00) {
-            throw std::runtime_error(bb_trace_message("JFIF marker not found"));
+        header = {marker_code, static_cast<uint16_t>(segment_length - 2)};
+        return bbexif::error_code_t::none;
+    }
+    
+    template <typename _Readable>
+    inline bbexif::jfif_segment_header_t read_jfif_segment_header(_Readable& r) {
+        bbexif::jfif_segment_header_t header;
+        auto const code = try_read_jfif_segment_header(r, header);
+        if (code != bbexif::error_code_t::none) {
+            bbexif::throw_error({code, 0});
         }
-        auto data_length = static_cast<uint16_t>(read<uint16_t>(r, byte_order_t::big_endian) - 2);
-        return {marker_code, data_length};
+        return header;
     }
     
     template <>
@@ -143,110 +550,176 @@ namespace bb {
         return {id, type, count, value_or_offset};
     }
     
+    template <byte_order_t _ByteOrder>
+    inline bbexif::ifd_tag_t read_ifd_tag(memory_reader& mr) {
+        auto id = read<uint16_t, _ByteOrder>(mr);
+        auto type = read<uint16_t, _ByteOrder>(mr);
+        auto count = read<uint32_t, _ByteOrder>(mr);
+        auto value_or_offset = read<uint32_t, _ByteOrder>(mr);
+        return {id, type, count, value_or_offset};
+    }
+    
     template <>
-    inline bbexif::ifd_t read(memory_reader& mr, byte_order_t const bo) {
+    inline bbexif::ifd_tag_type_rational_t binary_readable_traits<memory_reader>::peek(memory_reader& mr, size_t const cursor, byte_order_t const bo) {
+        return {peek<uint32_t>(mr, cursor + 0, bo), peek<uint32_t>(mr, cursor + 4, bo)};
+    }
+    
+    template <>
+    inline bbexif::ifd_tag_type_srational_t binary_readable_traits<memory_reader>::peek(memory_reader& mr, size_t const cursor, byte_order_t const bo) {
+        return {peek<int32_t>(mr, cursor + 0, bo), peek<int32_t>(mr, cursor + 4, bo)};
+    }
+    
+    // Reads an IFD entry at the cursor, returns false if it is skipped (e.g. not supported type)
+    // mr: must start at the TIFF header, because offsets of IFD entries are relative to it
+    template <byte_order_t _ByteOrder>
+    inline bool read_ifd_entry(memory_reader& mr, bbexif::ifd_entry_t& entry) {
         using namespace bbexif;
-        ifd_t ifd;
-        auto number_of_ifd_tags = bb::read<uint16_t>(mr, bo);
+        auto ifd_tag = bb::read_ifd_tag<_ByteOrder>(mr);
+        auto const type_info = ifd_tag_type_info(ifd_tag.type());
+        if (!type_info.is_supported) {
+            report_diagnostic(diagnostic_code_t::unsupported_type, ifd_tag.id(), ifd_tag.type(), ifd_tag.count());
+            return false;
+        }
+        
+        auto const tag_type = type_info.type;
+        auto const type_size = type_info.size;
+        uint64_t data_size = static_cast<uint64_t>(ifd_tag.count()) * type_size;
+        uint32_t offset;
+        if (data_size <= 4) {
+            // ifd_tag.value_or_offset_ is value(s)
+            if (type_size == 8) {
+                report_diagnostic(diagnostic_code_t::unsupported_inline_value, ifd_tag.id(), ifd_tag.type(), ifd_tag.count());
+                return false;
+            }
+            offset = static_cast<uint32_t>(mr.cursor() - 4);
+        }
+        else {
+            // ifd_tag.value_or_offset_ is offset to value(s)
+            offset = ifd_tag.offset();
+            if (mr.available(offset) < data_size) {
+                report_diagnostic(diagnostic_code_t::value_out_of_range, ifd_tag.id(), ifd_tag.type(), ifd_tag.count());
+                return false;
+            }
+        }
+        entry = {ifd_tag.id(), tag_type, ifd_tag.count(), offset};
+        return true;
+    }
+    
+    // mr: must start at the TIFF header, because offsets of IFD entries are relative to it
+    // Returns false if the IFD is out of mr (error_code_t::invalid_ifd)
+    template <byte_order_t _ByteOrder>
+    inline bool try_read_ifd_view(memory_reader& mr, bbexif::ifd_view_t& ifd) {
+        using namespace bbexif;
+        ifd.ptr_ = mr.ptr();
+        ifd.size_ = mr.size();
+        ifd.byte_order_ = _ByteOrder;
+        ifd.entries_.clear();
+        auto number_of_ifd_tags = bb::read<uint16_t, _ByteOrder>(mr);
         if (mr.available() < number_of_ifd_tags * sizeof(ifd_tag_t) + 4) {
-            throw std::runtime_error(bb_trace_message("Unable to read Exif"));
+            return false;
         }
+        ifd.entries_.reserve(number_of_ifd_tags);
+        bool is_sorted = true;
         for (auto ti = 0; ti < number_of_ifd_tags; ++ti) {
-            static std::map<uint16_t, ifd_tag_type_t> const ifd_tag_type_map = {
-                { 1, ifd_tag_type_t::byte },
-                { 2, ifd_tag_type_t::ascii },
-                { 3, ifd_tag_type_t::short_ },
-                { 4, ifd_tag_type_t::long_ },
-                { 5, ifd_tag_type_t::rational },
-                { 7, ifd_tag_type_t::undefined },
-                { 9, ifd_tag_type_t::slong },
-                { 10, ifd_tag_type_t::srational },
-            };
-            static std::map<ifd_tag_type_t, size_t> const type_size_map = {
-                { ifd_tag_type_t::byte, sizeof(ifd_tag_type_byte_t) },
-                { ifd_tag_type_t::ascii, sizeof(ifd_tag_type_ascii_t) },
-                { ifd_tag_type_t::short_, sizeof(ifd_tag_type_short_t) },
-                { ifd_tag_type_t::long_, sizeof(ifd_tag_type_long_t) },
-                { ifd_tag_type_t::rational, sizeof(ifd_tag_type_rational_t) },
-                { ifd_tag_type_t::undefined, sizeof(ifd_tag_type_undefined_t) },
-                { ifd_tag_type_t::slong, sizeof(ifd_tag_type_slong_t) },
-                { ifd_tag_type_t::srational, sizeof(ifd_tag_type_srational_t) },
-            };
-            
-            auto ifd_tag = bb::read<ifd_tag_t>(mr, bo);
-            ifd_tag_type_t tag_type;
-            try {
-                tag_type = ifd_tag_type_map.at(ifd_tag.type());
-            }
-            catch (std::out_of_range const& e) {
-                std::cout << bb::make_log_message("[Warning] Skipped reading the not supported type IFD tag: id=0x%04X, type=%d", ifd_tag.id(), ifd_tag.type()) << std::endl;
+            bbexif::ifd_entry_t entry;
+            if (!read_ifd_entry<_ByteOrder>(mr, entry)) {
                 continue;
             }
             
-            size_t type_size = type_size_map.at(tag_type);
-            std::vector<char> tag_data(ifd_tag.count() * type_size);
-            if (tag_data.size() <= 4) {
-                // ifd_tag.value_or_offset_ is value(s)
-                // HACK: ifd_tag.value() is not effective because that is read as uint32_t with specified byte order
-                auto offset = mr.cursor() - 4;
-                if (type_size == 1) {
-                    mr.peek(offset, reinterpret_cast<uint8_t*>(tag_data.data()), tag_data.size());
-                }
-                else if (type_size == 2 || type_size == 4) {
-                    for (auto vi = 0; vi < ifd_tag.count(); ++vi) {
-                        switch (type_size) {
-                            case 2:
-                                *reinterpret_cast<uint16_t*>(tag_data.data() + type_size * vi) = bb::peek<uint16_t>(mr, offset + type_size * vi, bo);
-                                break;
-                            case 4:
-                                *reinterpret_cast<uint32_t*>(tag_data.data() + type_size * vi) = bb::peek<uint32_t>(mr, offset + type_size * vi, bo);
-                                break;
-                        }
-                    }
-                }
-                else {
-                    std::cout << bb::make_log_message("[Warning] Skipped reading the not supported type IFD tag: id=0x%04X, type=%d", ifd_tag.id(), ifd_tag.type()) << std::endl;
-                    continue;
-                }
+            if (!ifd.entries_.empty() && ifd.entries_.back().id() >= entry.id()) {
+                is_sorted = false;
             }
-            else {
-                // ifd_tag.value_or_offset_ is offset to value(s)
-                auto offset = ifd_tag.offset();
-                if (mr.available(offset) < tag_data.size()) {
-                    std::cout << bb::make_log_message("[Warning] Skipped reading the not supported type IFD tag: id=0x%04X, type=%d", ifd_tag.id(), ifd_tag.type()) << std::endl;
-                    continue;
-                }
-                if (type_size == 1) {
-                    mr.peek(offset, reinterpret_cast<uint8_t*>(tag_data.data()), tag_data.size());
-                }
-                else if (type_size == 2 || type_size == 4 || type_size == 8) {
-                    for (auto vi = 0; vi < ifd_tag.count(); ++vi) {
-                        switch (type_size) {
-                            case 2:
-                                *reinterpret_cast<uint16_t*>(tag_data.data() + type_size * vi) = bb::peek<uint16_t>(mr, offset + type_size * vi, bo);
-                                break;
-                            case 4:
-                                *reinterpret_cast<uint32_t*>(tag_data.data() + type_size * vi) = bb::peek<uint32_t>(mr, offset + type_size * vi, bo);
-                                break;
-                            case 8:
-                                *reinterpret_cast<uint32_t*>(tag_data.data() + type_size * vi + 0) = bb::peek<uint32_t>(mr, offset + type_size * vi + 0, bo);
-                                *reinterpret_cast<uint32_t*>(tag_data.data() + type_size * vi + 4) = bb::peek<uint32_t>(mr, offset + type_size * vi + 4, bo);
-                                break;
-                        }
-                    }
-                }
-                else {
-                    std::cout << bb::make_log_message("[Warning] Skipped reading the not supported type IFD tag: id=0x%04X, type=%d", ifd_tag.id(), ifd_tag.type()) << std::endl;
+            ifd.entries_.push_back(entry);
+        }
+        
+        if (!is_sorted) {
+            // IFD entries should be sorted, but keep the last one of the same id like std::map::operator[]
+            auto& entries = ifd.entries_;
+            std::stable_sort(entries.begin(), entries.end(), [](ifd_entry_t const& lhs, ifd_entry_t const& rhs) {
+                return lhs.id() < rhs.id();
+            });
+            auto out = entries.begin();
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (it + 1 != entries.end() && (it + 1)->id() == it->id()) {
                     continue;
                 }
+                *out++ = *it;
             }
-            
+            entries.erase(out, entries.end());
+        }
+        
+        return true;
+    }
+    
+    template <byte_order_t _ByteOrder>
+    inline bbexif::ifd_view_t read_ifd_view(memory_reader& mr) {
+        bbexif::ifd_view_t ifd;
+        if (!try_read_ifd_view<_ByteOrder>(mr, ifd)) {
+            bbexif::throw_error({bbexif::error_code_t::invalid_ifd, mr.cursor()});
+        }
+        return ifd;
+    }
+    
+    template <>
+    inline bbexif::ifd_view_t read<bbexif::ifd_view_t, byte_order_t::little_endian>(memory_reader& mr) {
+        return read_ifd_view<byte_order_t::little_endian>(mr);
+    }
+    
+    template <>
+    inline bbexif::ifd_view_t read<bbexif::ifd_view_t, byte_order_t::big_endian>(memory_reader& mr) {
+        return read_ifd_view<byte_order_t::big_endian>(mr);
+    }
+    
+    // Prefer read<bbexif::ifd_view_t, byte_order_t>(mr) to dispatch the byte order at once for a file
+    template <>
+    inline bbexif::ifd_view_t read(memory_reader& mr, byte_order_t const bo) {
+        if (bo == byte_order_t::big_endian || (bo == byte_order_t::native && native_byte_order_constant == byte_order_t::big_endian)) {
+            return read_ifd_view<byte_order_t::big_endian>(mr);
+        }
+        return read_ifd_view<byte_order_t::little_endian>(mr);
+    }
+}
+
+namespace bbexif {
+    // I/O of a call, for file_access_t::prefix
+    struct read_stats_t {
+        size_t number_of_reads = 0;
+        uint64_t bytes_read = 0;
+    };
+    
+    struct read_options_t {
+        bool copies_thumbnail = true; // if false, exif_t::thumbnail is empty, see exif_t::thumbnail_location
+        size_t prefix_size = 64 * 1024; // for file_access_t::prefix
+        read_stats_t* stats = nullptr; // filled if specified
+        diagnostics_sink_t* diagnostics = nullptr; // installed while reading, see scoped_diagnostics_sink_t
+        traversal_budget_t budget;
+    };
+    
+    ifd_t make_ifd(ifd_view_t const& view);
+    ifd_t make_ifd(ifd_view_t const& view, bb::memory_resource* resource);
+    exif_t make_exif(exif_view_t const& view);
+    exif_t make_exif(exif_view_t const& view, bb::memory_resource* resource);
+    exif_t make_exif(exif_view_t const& view, bb::memory_resource* resource, read_options_t const& options);
+    void locate_thumbnail(exif_t& exif, uint64_t const tiff_offset);
+    
+    ifd_t make_ifd(ifd_view_t const& view) {
+        return make_ifd(view, bb::new_delete_resource());
+    }
+    
+    // resource: allocates tag data from it, must outlive the returned ifd_t (except its copies)
+    ifd_t make_ifd(ifd_view_t const& view, bb::memory_resource* resource) {
+        ifd_t ifd;
+        ifd.reserve(view.size());
+        for (auto const& entry: view.entries()) {
+            auto value = view.value(entry);
+            data_t tag_data(value.size(), data_t::allocator_type(resource));
+            value.copy_to(tag_data.data());
 #ifdef DEBUG
             if (0) {
                 std::stringstream ss;
                 ss << std::setfill('0');
-                ss << std::hex << std::setw(4) << ifd_tag.id() << ": ";
-                ss << std::dec << static_cast<uint16_t>(tag_type) << " { ";
+                ss << std::hex << std::setw(4) << entry.id() << ": ";
+                ss << std::dec << static_cast<uint16_t>(entry.type()) << " { ";
                 ss << std::hex;
                 for (auto const& d: tag_data) {
                     ss << std::setw(2) << (+d < 0 ? d + 256 : +d) << " ";
@@ -255,192 +728,736 @@ namespace bb {
                 std::cout << "[D] " << ss.str() << std::endl;
             }
 #endif
-            ifd[ifd_tag.id()] = {tag_type, ifd_tag.count(), std::move(tag_data)};
+            ifd.emplace_hint(ifd.end(), entry.id(), ifd_value_t{entry.type(), entry.count(), std::move(tag_data)});
         }
-        
         return ifd;
     }
+    
+    exif_t make_exif(exif_view_t const& view) {
+        return make_exif(view, bb::new_delete_resource());
+    }
+    
+    // resource: allocates tag data and the thumbnail from it, must outlive the returned exif_t (except its copies)
+    // e.g. bb::monotonic_buffer_resource for each thread, and release() it after using the exif_t
+    exif_t make_exif(exif_view_t const& view, bb::memory_resource* resource) {
+        return make_exif(view, resource, read_options_t());
+    }
+    
+    // The thumbnail location is relative to the TIFF header, see locate_thumbnail()
+    exif_t make_exif(exif_view_t const& view, bb::memory_resource* resource, read_options_t const& options) {
+        std::vector<ifd_t> ifds;
+        ifds.reserve(view.ifds.size());
+        for (auto const& ifd: view.ifds) {
+            ifds.push_back(make_ifd(ifd, resource));
+        }
+        auto thumbnail = data_t(data_t::allocator_type(resource));
+        if (options.copies_thumbnail) {
+            thumbnail.assign(view.thumbnail_data, view.thumbnail_data + view.thumbnail_size);
+        }
+        thumbnail_location_t thumbnail_location{0, 0};
+        if (view.thumbnail_data && !view.ifds.empty()) {
+            thumbnail_location = {static_cast<uint64_t>(view.thumbnail_data - view.ifds[0].ptr_), view.thumbnail_size};
+        }
+        std::vector<ifd_t> sub_ifds;
+        sub_ifds.reserve(view.sub_ifds.size());
+        for (auto const& ifd: view.sub_ifds) {
+            sub_ifds.push_back(make_ifd(ifd, resource));
+        }
+        return {std::move(ifds), make_ifd(view.exif, resource), make_ifd(view.gps, resource), std::move(thumbnail), thumbnail_location, make_ifd(view.interop, resource), std::move(sub_ifds), make_ifd(view.maker_note, resource)};
+    }
+    
+    // Makes the thumbnail location relative to the source, where the TIFF header is at tiff_offset
+    void locate_thumbnail(exif_t& exif, uint64_t const tiff_offset) {
+        if (exif.thumbnail_location.size > 0) {
+            exif.thumbnail_location.offset += tiff_offset;
+        }
+    }
+}
+
+// extension bb::binary_reader
+namespace bb {
+    // mr: must start at the TIFF header, see read<bbexif::ifd_view_t>
+    template <>
+    inline bbexif::ifd_t read(memory_reader& mr, byte_order_t const bo) {
+        return bbexif::make_ifd(read<bbexif::ifd_view_t>(mr, bo));
+    }
+    
+    template <>
+    inline bbexif::ifd_t read<bbexif::ifd_t, byte_order_t::little_endian>(memory_reader& mr) {
+        return bbexif::make_ifd(read<bbexif::ifd_view_t, byte_order_t::little_endian>(mr));
+    }
+    
+    template <>
+    inline bbexif::ifd_t read<bbexif::ifd_t, byte_order_t::big_endian>(memory_reader& mr) {
+        return bbexif::make_ifd(read<bbexif::ifd_view_t, byte_order_t::big_endian>(mr));
+    }
 }
 
 namespace bbexif {
+    enum class file_access_t {
+        stream, // std::ifstream
+        mmap, // falls back to stream if the file can not be mapped (e.g. pipe)
+        prefix, // pread() read_options_t::prefix_size bytes at first, and the rest of APP1 only if needed; falls back to stream
+    };
+    
     exif_t read_exif(std::string const& filepath);
+    exif_t read_exif(std::string const& filepath, file_access_t const access);
+    exif_t read_exif(std::string const& filepath, file_access_t const access, read_options_t const& options);
     exif_t read_exif(std::istream& is);
+    data_t read_thumbnail(std::string const& filepath, thumbnail_location_t const& location);
+    exif_t read_exif_from_jpeg(char const* ptr, size_t const size);
+    exif_view_t read_exif_view_from_jpeg(char const* ptr, size_t const size);
     exif_t read_exif_from_app1_segment(char const* ptr, size_t const size);
+    exif_view_t read_exif_view_from_app1_segment(char const* ptr, size_t const size);
+    template <bb::byte_order_t _ByteOrder>
+    exif_view_t read_exif_view_from_tiff(bb::memory_reader& mr);
+    
+    std::pair<char const*, size_t> find_app1_segment(char const* ptr, size_t const size);
+    template <typename _ChunkReader>
+    bb::memory_reader read_app1_segment(_ChunkReader& reader);
+    bb::byte_order_t read_exif_header(bb::memory_reader& mr);
+    template <typename _F>
+    auto with_app1_segment(std::string const& filepath, file_access_t const access, read_options_t const& options, _F f) -> decltype(f(nullptr, 0, 0));
+    
+    // Exception-free versions of the above, except std::bad_alloc
+    result_t<exif_t> try_read_exif(std::string const& filepath);
+    result_t<exif_t> try_read_exif(std::string const& filepath, file_access_t const access);
+    result_t<exif_t> try_read_exif(std::string const& filepath, file_access_t const access, read_options_t const& options);
+    result_t<exif_t> try_read_exif(int const fd, file_access_t const access, read_options_t const& options);
+    result_t<exif_t> try_read_exif(std::istream& is);
+    result_t<exif_t> try_read_exif_from_jpeg(char const* ptr, size_t const size);
+    result_t<exif_view_t> try_read_exif_view_from_jpeg(char const* ptr, size_t const size);
+    result_t<exif_t> try_read_exif_from_app1_segment(char const* ptr, size_t const size);
+    result_t<exif_t> try_read_exif_from_app1_segment(char const* ptr, size_t const size, uint64_t const offset, read_options_t const& options);
+    result_t<exif_view_t> try_read_exif_view_from_app1_segment(char const* ptr, size_t const size);
+    result_t<exif_view_t> try_read_exif_view_from_app1_segment(char const* ptr, size_t const size, traversal_budget_t const& budget);
+    template <bb::byte_order_t _ByteOrder>
+    result_t<exif_view_t> try_read_exif_view_from_tiff(bb::memory_reader& mr);
+    template <bb::byte_order_t _ByteOrder>
+    result_t<exif_view_t> try_read_exif_view_from_tiff(bb::memory_reader& mr, traversal_budget_t const& budget);
+    
+    result_t<std::pair<char const*, size_t>> try_find_app1_segment(char const* ptr, size_t const size);
+    template <typename _ChunkReader>
+    result_t<bb::memory_reader> try_read_app1_segment(_ChunkReader& reader);
+    result_t<bb::byte_order_t> try_read_exif_header(bb::memory_reader& mr);
+    template <typename _F>
+    auto try_with_app1_segment(std::string const& filepath, file_access_t const access, read_options_t const& options, _F f) -> decltype(f(nullptr, 0, 0));
+    template <typename _F>
+    auto try_with_app1_segment(int const fd, file_access_t const access, read_options_t const& options, _F f) -> decltype(f(nullptr, 0, 0));
+    template <typename _ChunkReader, typename _F>
+    auto try_with_app1_segment(_ChunkReader& reader, _F& f) -> decltype(f(nullptr, 0, 0));
+    
+    // "Exif\0\0" followed by the TIFF header
+    static size_t const exif_header_size = 6;
+    
+    // The error is at base + error.offset()
+    inline bb::unexpected<error_t> make_error(error_t const& error, uint64_t const base) {
+        return make_error(error.code(), base + error.offset());
+    }
     
     exif_t read_exif(std::string const& filepath) {
+        return read_exif(filepath, file_access_t::mmap);
+    }
+    
+    exif_t read_exif(std::string const& filepath, file_access_t const access) {
+        return read_exif(filepath, access, read_options_t());
+    }
+    
+    exif_t read_exif(std::string const& filepath, file_access_t const access, read_options_t const& options) {
+        return value_or_throw(try_read_exif(filepath, access, options), filepath);
+    }
+    
+    exif_t read_exif(std::istream& is) {
+        return value_or_throw(try_read_exif(is));
+    }
+    
+    // Reads the thumbnail at the location of exif_t::thumbnail_location
+    data_t read_thumbnail(std::string const& filepath, thumbnail_location_t const& location) {
+        data_t thumbnail(location.size);
+        if (location.size == 0) {
+            return thumbnail;
+        }
         std::ifstream ifs;
         ifs.open(filepath, std::ios::binary);
         if (!ifs.is_open()) {
             throw std::runtime_error(bb_trace_message("Unable to open the file: %s", filepath.c_str()));
         }
-        return read_exif(ifs);
+        ifs.seekg(static_cast<std::streamoff>(location.offset));
+        ifs.read(thumbnail.data(), static_cast<std::streamsize>(location.size));
+        if (static_cast<size_t>(ifs.gcount()) != location.size) {
+            throw std::runtime_error(bb_trace_message("Unable to read the thumbnail"));
+        }
+        return thumbnail;
     }
     
-    exif_t read_exif(std::istream& is) {
+    exif_t read_exif_from_jpeg(char const* ptr, size_t const size) {
+        return value_or_throw(try_read_exif_from_jpeg(ptr, size));
+    }
+    
+    exif_view_t read_exif_view_from_jpeg(char const* ptr, size_t const size) {
+        return value_or_throw(try_read_exif_view_from_jpeg(ptr, size));
+    }
+    
+    exif_t read_exif_from_app1_segment(char const* ptr, size_t const size) {
+        return value_or_throw(try_read_exif_from_app1_segment(ptr, size));
+    }
+    
+    exif_view_t read_exif_view_from_app1_segment(char const* ptr, size_t const size) {
+        return value_or_throw(try_read_exif_view_from_app1_segment(ptr, size));
+    }
+    
+    template <bb::byte_order_t _ByteOrder>
+    exif_view_t read_exif_view_from_tiff(bb::memory_reader& mr) {
+        return value_or_throw(try_read_exif_view_from_tiff<_ByteOrder>(mr));
+    }
+    
+    std::pair<char const*, size_t> find_app1_segment(char const* ptr, size_t const size) {
+        return value_or_throw(try_find_app1_segment(ptr, size));
+    }
+    
+    template <typename _ChunkReader>
+    bb::memory_reader read_app1_segment(_ChunkReader& reader) {
+        return value_or_throw(try_read_app1_segment(reader));
+    }
+    
+    bb::byte_order_t read_exif_header(bb::memory_reader& mr) {
+        return value_or_throw(try_read_exif_header(mr));
+    }
+    
+    // f: (ptr, size, offset) -> value, may throw, see try_with_app1_segment()
+    template <typename _F>
+    auto with_app1_segment(std::string const& filepath, file_access_t const access, read_options_t const& options, _F f) -> decltype(f(nullptr, 0, 0)) {
+        using value_type = decltype(f(nullptr, 0, 0));
+        return value_or_throw(try_with_app1_segment(filepath, access, options, [&f](char const* ptr, size_t const size, uint64_t const offset) {
+            return result_t<value_type>(f(ptr, size, offset));
+        }), filepath);
+    }
+    
+    // The thumbnail location is from the beginning of the file
+    result_t<exif_t> try_read_exif(std::string const& filepath) {
+        return try_read_exif(filepath, file_access_t::mmap);
+    }
+    
+    result_t<exif_t> try_read_exif(std::string const& filepath, file_access_t const access) {
+        return try_read_exif(filepath, access, read_options_t());
+    }
+    
+    result_t<exif_t> try_read_exif(std::string const& filepath, file_access_t const access, read_options_t const& options) {
+        // keeps the sink installed by the caller if not specified
+        scoped_diagnostics_sink_t diagnostics(options.diagnostics ? options.diagnostics : current_diagnostics_sink());
+        return try_with_app1_segment(filepath, access, options, [&options](char const* ptr, size_t const size, uint64_t const offset) -> result_t<exif_t> {
+            return try_read_exif_from_app1_segment(ptr, size, offset, options);
+        });
+    }
+    
+    // fd: opened by the caller, e.g. to fstat() the same file as read
+    result_t<exif_t> try_read_exif(int const fd, file_access_t const access, read_options_t const& options) {
+        scoped_diagnostics_sink_t diagnostics(options.diagnostics ? options.diagnostics : current_diagnostics_sink());
+        return try_with_app1_segment(fd, access, options, [&options](char const* ptr, size_t const size, uint64_t const offset) -> result_t<exif_t> {
+            return try_read_exif_from_app1_segment(ptr, size, offset, options);
+        });
+    }
+    
+    // The thumbnail location and the error offset are from the position of the stream when called
+    result_t<exif_t> try_read_exif(std::istream& is) {
         auto const iostatus = is.exceptions();
         auto revert_exceptions = bb::make_scope_exit([&is, &iostatus]() {
             is.exceptions(iostatus);
         });
-        is.exceptions(std::istream::eofbit);
+        // The end of the stream is checked by the size of read chunks
+        is.exceptions(std::istream::goodbit);
         
-        std::vector<char> app1_segment_data;
-        try {
-            if (bb::read<jfif_segment_header_t>(is).marker_code != 0xFFD8) {
-                throw std::exception();
+        bb::istream_chunk_reader reader(is);
+        auto mr = try_read_app1_segment(reader);
+        if (!mr) {
+            return bb::make_unexpected(mr.error());
+        }
+        auto const offset = reader.position() - mr->size();
+        auto view = try_read_exif_view_from_app1_segment(reinterpret_cast<char const*>(mr->ptr()), mr->size());
+        if (!view) {
+            return make_error(view.error(), offset);
+        }
+        auto exif = make_exif(*view);
+        locate_thumbnail(exif, offset + exif_header_size);
+        return exif;
+    }
+    
+    // The thumbnail location and the error offset are from ptr
+    result_t<exif_t> try_read_exif_from_jpeg(char const* ptr, size_t const size) {
+        auto app1_segment = try_find_app1_segment(ptr, size);
+        if (!app1_segment) {
+            return bb::make_unexpected(app1_segment.error());
+        }
+        auto const offset = static_cast<uint64_t>(app1_segment->first - ptr);
+        auto view = try_read_exif_view_from_app1_segment(app1_segment->first, app1_segment->second);
+        if (!view) {
+            return make_error(view.error(), offset);
+        }
+        auto exif = make_exif(*view);
+        locate_thumbnail(exif, offset + exif_header_size);
+        return exif;
+    }
+    
+    // The returned view refers to [ptr, ptr + size)
+    result_t<exif_view_t> try_read_exif_view_from_jpeg(char const* ptr, size_t const size) {
+        auto app1_segment = try_find_app1_segment(ptr, size);
+        if (!app1_segment) {
+            return bb::make_unexpected(app1_segment.error());
+        }
+        auto view = try_read_exif_view_from_app1_segment(app1_segment->first, app1_segment->second);
+        if (!view) {
+            return make_error(view.error(), static_cast<uint64_t>(app1_segment->first - ptr));
+        }
+        return view;
+    }
+    
+    // Calls f(ptr, size, offset) with the APP1 segment data of the file, which is valid only in f
+    // f: returns result_t<...>, whose error offset is from ptr
+    // offset: of the APP1 segment data in the file
+    template <typename _F>
+    auto try_with_app1_segment(std::string const& filepath, file_access_t const access, read_options_t const& options, _F f) -> decltype(f(nullptr, 0, 0)) {
+        if (access == file_access_t::prefix) {
+            // reused by calls on the same thread
+            thread_local std::vector<uint8_t> buffer;
+            bb::file_chunk_reader reader(buffer);
+            if (reader.open(filepath.c_str(), options.prefix_size)) {
+                auto record_stats = bb::make_scope_exit([&reader, &options]() {
+                    if (options.stats) {
+                        options.stats->number_of_reads = reader.number_of_reads();
+                        options.stats->bytes_read = reader.bytes_read();
+                    }
+                });
+                return try_with_app1_segment(reader, f);
             }
-            auto jfif_segment = bb::read<jfif_segment_header_t>(is);
-            if (jfif_segment.marker_code != 0xFFE1) {
-                // This is not SOI segment
-                throw std::runtime_error(bb_trace_message("APP1 segment not found"));
+        }
+        else if (access == file_access_t::mmap) {
+            bb::mapped_file file;
+            if (file.open(filepath.c_str())) {
+#if BB_MAPPED_FILE_AVAILABLE
+                // Only the beginning of the file is needed, so avoid the kernel reading ahead the whole image data
+                file.advise(0, file.size(), MADV_RANDOM);
+                file.advise(0, 64 * 1024, MADV_WILLNEED);
+#endif
+                bb::memory_chunk_reader reader(file.ptr(), file.size());
+                return try_with_app1_segment(reader, f);
             }
-            // APP1 segment must be recorded immediately after SOI
-            app1_segment_data.resize(jfif_segment.data_length);
-            is.read(reinterpret_cast<char*>(app1_segment_data.data()), jfif_segment.data_length);
         }
-        catch (std::exception const&) {
-            throw std::runtime_error(bb_trace_message("Unable to read a exif"));
+        
+        std::ifstream ifs;
+        ifs.open(filepath, std::ios::binary);
+        if (!ifs.is_open()) {
+            return make_error(error_code_t::file_not_opened, 0);
         }
-        return read_exif_from_app1_segment(app1_segment_data.data(), app1_segment_data.size());
+        // The end of the stream is checked by the size of read chunks
+        ifs.exceptions(std::istream::goodbit);
+        bb::istream_chunk_reader reader(ifs);
+        return try_with_app1_segment(reader, f);
     }
     
-    exif_t read_exif_from_app1_segment(char const* ptr, size_t const size) {
-        auto mr = bb::memory_reader(reinterpret_cast<uint8_t const*>(ptr), size);
+    // Same as above for the file opened by the caller, which is not closed
+    // fd: a regular file, file_access_t::stream reads it as file_access_t::prefix
+    template <typename _F>
+    auto try_with_app1_segment(int const fd, file_access_t const access, read_options_t const& options, _F f) -> decltype(f(nullptr, 0, 0)) {
+        if (access == file_access_t::mmap) {
+            bb::mapped_file file;
+            if (file.open(fd)) {
+#if BB_MAPPED_FILE_AVAILABLE
+                file.advise(0, file.size(), MADV_RANDOM);
+                file.advise(0, 64 * 1024, MADV_WILLNEED);
+#endif
+                bb::memory_chunk_reader reader(file.ptr(), file.size());
+                return try_with_app1_segment(reader, f);
+            }
+        }
         
+        thread_local std::vector<uint8_t> buffer;
+        bb::file_chunk_reader reader(buffer);
+        if (!reader.open(fd, options.prefix_size)) {
+            return make_error(error_code_t::file_not_opened, 0);
+        }
+        auto record_stats = bb::make_scope_exit([&reader, &options]() {
+            if (options.stats) {
+                options.stats->number_of_reads = reader.number_of_reads();
+                options.stats->bytes_read = reader.bytes_read();
+            }
+        });
+        return try_with_app1_segment(reader, f);
+    }
+    
+    // reader: at the beginning of the JPEG data
+    template <typename _ChunkReader, typename _F>
+    auto try_with_app1_segment(_ChunkReader& reader, _F& f) -> decltype(f(nullptr, 0, 0)) {
+        auto mr = try_read_app1_segment(reader);
+        if (!mr) {
+            return bb::make_unexpected(mr.error());
+        }
+        auto const offset = reader.position() - mr->size();
+        auto result = f(reinterpret_cast<char const*>(mr->ptr()), mr->size(), offset);
+        if (!result) {
+            return make_error(result.error(), offset);
+        }
+        return result;
+    }
+    
+    // Returns [ptr, size) of the APP1 segment data in the JPEG data
+    result_t<std::pair<char const*, size_t>> try_find_app1_segment(char const* ptr, size_t const size) {
+        bb::memory_chunk_reader reader(reinterpret_cast<uint8_t const*>(ptr), size);
+        auto mr = try_read_app1_segment(reader);
+        if (!mr) {
+            return bb::make_unexpected(mr.error());
+        }
+        return std::make_pair(reinterpret_cast<char const*>(mr->ptr()), mr->size());
+    }
+    
+    // Walks segments from SOI to SOS, and returns memory_reader refers to the Exif APP1 segment data in a chunk of reader
+    // Other segments (e.g. APP0, APP2, COM, and APP1 for XMP) are skipped without reading
+    // _ChunkReader: bb::istream_chunk_reader, bb::memory_chunk_reader, or bb::file_chunk_reader
+    template <typename _ChunkReader>
+    result_t<bb::memory_reader> try_read_app1_segment(_ChunkReader& reader) {
+        jfif_segment_header_t jfif_segment;
+        {
+            auto mr = reader.read(2);
+            if (mr.available() < 2 || bb::try_read_jfif_segment_header(mr, jfif_segment) != error_code_t::none || jfif_segment.marker_code != 0xFFD8) {
+                return make_error(error_code_t::not_jpeg, reader.position() - mr.size());
+            }
+        }
+        for (;;) {
+            auto mr = reader.read(2);
+            auto position = reader.position() - mr.size();
+            if (mr.available() < 2) {
+                return make_error(error_code_t::truncated, position);
+            }
+            uint8_t header[2 + 2] = {mr.ptr()[0], mr.ptr()[1]};
+            // Any number of fill bytes (0xFF) may precede the marker code (T.81 B.1.1.2)
+            while (header[0] == 0xFF && header[1] == 0xFF) {
+                mr = reader.read(1);
+                if (mr.available() < 1) {
+                    return make_error(error_code_t::truncated, reader.position());
+                }
+                header[1] = mr.ptr()[0];
+                ++position;
+            }
+            mr = reader.read(2);
+            if (mr.available() < 2) {
+                return make_error(error_code_t::truncated, position);
+            }
+            header[2] = mr.ptr()[0];
+            header[3] = mr.ptr()[1];
+            auto header_mr = bb::memory_reader(header, sizeof(header));
+            auto const code = bb::try_read_jfif_segment_header(header_mr, jfif_segment);
+            if (code != error_code_t::none) {
+                return make_error(code, position);
+            }
+            if (jfif_segment.marker_code == 0xFFD9 || jfif_segment.marker_code == 0xFFDA) {
+                // EOI or SOS, APP1 segment must be recorded before the image data
+                return make_error(error_code_t::app1_not_found, position);
+            }
+            
+            auto skip_size = static_cast<size_t>(jfif_segment.data_length);
+            if (jfif_segment.marker_code == 0xFFE1 && jfif_segment.data_length >= exif_header_size) {
+                mr = reader.read(exif_header_size);
+                if (mr.available() < exif_header_size) {
+                    return make_error(error_code_t::truncated, reader.position());
+                }
+                if (::memcmp(mr.ptr(), "Exif\0\0", exif_header_size) == 0) {
+                    mr = reader.extend(jfif_segment.data_length - exif_header_size);
+                    if (mr.available() < jfif_segment.data_length) {
+                        return make_error(error_code_t::truncated, reader.position());
+                    }
+                    return mr;
+                }
+                // APP1 segment for other than Exif (e.g. XMP)
+                skip_size -= exif_header_size;
+            }
+            if (!reader.skip(skip_size)) {
+                return make_error(error_code_t::truncated, reader.position());
+            }
+        }
+    }
+    
+    // The thumbnail location and the error offset are from ptr
+    result_t<exif_t> try_read_exif_from_app1_segment(char const* ptr, size_t const size) {
+        auto view = try_read_exif_view_from_app1_segment(ptr, size);
+        if (!view) {
+            return bb::make_unexpected(view.error());
+        }
+        auto exif = make_exif(*view);
+        locate_thumbnail(exif, exif_header_size);
+        return exif;
+    }
+    
+    // offset: of ptr in the source, the thumbnail location is from the source
+    // The error offset is from ptr
+    result_t<exif_t> try_read_exif_from_app1_segment(char const* ptr, size_t const size, uint64_t const offset, read_options_t const& options) {
+        auto view = try_read_exif_view_from_app1_segment(ptr, size, options.budget);
+        if (!view) {
+            return bb::make_unexpected(view.error());
+        }
+        auto exif = make_exif(*view, bb::new_delete_resource(), options);
+        locate_thumbnail(exif, offset + exif_header_size);
+        return exif;
+    }
+    
+    // The returned view refers to [ptr, ptr + size)
+    result_t<exif_view_t> try_read_exif_view_from_app1_segment(char const* ptr, size_t const size) {
+        return try_read_exif_view_from_app1_segment(ptr, size, traversal_budget_t());
+    }
+    
+    result_t<exif_view_t> try_read_exif_view_from_app1_segment(char const* ptr, size_t const size, traversal_budget_t const& budget) {
+        auto mr = bb::memory_reader(reinterpret_cast<uint8_t const*>(ptr), size);
+        auto const bo = try_read_exif_header(mr);
+        if (!bo) {
+            return bb::make_unexpected(bo.error());
+        }
+        // dispatch the byte order at once, the rest is compiled for each byte order
+        auto view = *bo == bb::byte_order_t::big_endian ? try_read_exif_view_from_tiff<bb::byte_order_t::big_endian>(mr, budget) : try_read_exif_view_from_tiff<bb::byte_order_t::little_endian>(mr, budget);
+        if (!view) {
+            return make_error(view.error(), exif_header_size);
+        }
+        return view;
+    }
+    
+    // Reads the Exif identifier code and the byte order of the TIFF header
+    // mr: APP1 segment data, is reset to start at the TIFF header and moved to the version field
+    result_t<bb::byte_order_t> try_read_exif_header(bb::memory_reader& mr) {
         if (mr.available() < 6 + 2 + 2 + 4) {
-            throw std::runtime_error(bb_trace_message("Exif not found"));
+            return make_error(error_code_t::exif_not_found, 0);
         }
         {
             uint8_t exif_id_code[6];
             mr.read(exif_id_code, sizeof(exif_id_code));
             if (::memcmp(exif_id_code, "Exif\0\0", sizeof(exif_id_code))) {
-                throw std::runtime_error(bb_trace_message("Exif not found"));
+                return make_error(error_code_t::exif_not_found, 0);
             }
         }
         // Exif identifier header
         mr.reset(mr.ptr() + mr.cursor(), mr.available());
         // TIFF header
-        bb::byte_order_t const bo = [](uint16_t byte_order) {
-            switch (byte_order) {
+        switch (bb::read<uint16_t>(mr)) {
             case 0x4949: // "II"
                 return bb::byte_order_t::little_endian;
             case 0x4D4D: // "MM"
                 return bb::byte_order_t::big_endian;
             default:
-                throw std::runtime_error(bb_trace_message("Exif not found"));
-            }
-        }(bb::read<uint16_t>(mr));
-        if (bb::read<uint16_t>(mr, bo) != 0x002A) {
-            throw std::runtime_error(bb_trace_message("Unsupported Exif version"));
+                return make_error(error_code_t::exif_not_found, exif_header_size);
+        }
+    }
+    
+    // mr: at the version field, next to the byte order of the TIFF header
+    // The error offset is from the TIFF header
+    template <bb::byte_order_t _ByteOrder>
+    result_t<exif_view_t> try_read_exif_view_from_tiff(bb::memory_reader& mr) {
+        return try_read_exif_view_from_tiff<_ByteOrder>(mr, traversal_budget_t());
+    }
+    
+    template <bb::byte_order_t _ByteOrder>
+    result_t<exif_view_t> try_read_exif_view_from_tiff(bb::memory_reader& mr, traversal_budget_t const& budget) {
+        if (bb::read<uint16_t, _ByteOrder>(mr) != 0x002A) {
+            return make_error(error_code_t::unsupported_version, mr.cursor() - 2);
         }
         
-        std::vector<ifd_t> ifds;
+        // Each IFD is read at most once and within the budget, so the traversal ends even if offsets loop
+        enum class visit_t {
+            read,
+            skipped, // reported as a diagnostic of the pointer tag
+            invalid,
+        };
+        std::vector<uint32_t> visited_offsets;
+        size_t remaining_ifds = budget.max_ifds;
+        size_t remaining_bytes = budget.max_bytes;
+        // ifd_mr: at the IFD, is moved to the offset to the next IFD
+        // pointer: the tag pointing to the IFD, nullptr for the linked IFD
+        auto visit_ifd = [&visited_offsets, &remaining_ifds, &remaining_bytes](bb::memory_reader& ifd_mr, ifd_entry_t const* pointer, ifd_view_t& ifd) {
+            auto const offset = static_cast<uint32_t>(ifd_mr.cursor());
+            auto report = [pointer, offset](diagnostic_code_t const code) {
+                if (pointer) {
+                    report_diagnostic(code, pointer->id(), ifd_tag_type_info(pointer->type()).code, pointer->count());
+                }
+                else {
+                    report_linked_ifd_diagnostic(code, offset);
+                }
+            };
+            if (std::find(visited_offsets.begin(), visited_offsets.end(), offset) != visited_offsets.end()) {
+                report(diagnostic_code_t::ifd_visited);
+                return visit_t::skipped;
+            }
+            if (remaining_ifds == 0) {
+                report(diagnostic_code_t::budget_exceeded);
+                return visit_t::skipped;
+            }
+            if (ifd_mr.available() < 2 || !bb::try_read_ifd_view<_ByteOrder>(ifd_mr, ifd)) {
+                ifd = ifd_view_t();
+                return visit_t::invalid;
+            }
+            // entries and the offset to the next IFD, and values out of entries
+            size_t bytes = ifd_mr.cursor() + 4 - offset;
+            for (auto const& entry: ifd.entries()) {
+                auto const size = entry.count() * ifd_tag_type_size(entry.type());
+                bytes += size > 4 ? size : 0;
+            }
+            if (remaining_bytes < bytes) {
+                ifd = ifd_view_t();
+                report(diagnostic_code_t::budget_exceeded);
+                return visit_t::skipped;
+            }
+            visited_offsets.push_back(offset);
+            --remaining_ifds;
+            remaining_bytes -= bytes;
+            return visit_t::read;
+        };
+        
+        std::vector<ifd_view_t> ifds;
         // IFD (loop)
         for (;;) {
-            auto next_ifd_offset = bb::read<uint32_t>(mr, bo);
+            auto next_ifd_offset = bb::read<uint32_t, _ByteOrder>(mr);
             if (next_ifd_offset == 0) {
                 // This means there is no linked IFD
                 break;
             }
-            if (next_ifd_offset < mr.cursor()) {
-                throw std::runtime_error(bb_trace_message("Unable to read Exif"));
-            }
+            // A backward offset is also followed, visit_ifd() ends the chain if it loops
             if (mr.available(next_ifd_offset) < 4 + 0 + 4) {
-                throw std::runtime_error(bb_trace_message("Unable to read Exif"));
+                return make_error(error_code_t::invalid_ifd, mr.cursor() - 4);
             }
             mr.move_to(next_ifd_offset);
             
-            auto ifd = bb::read<ifd_t>(mr, bo);
+            ifd_view_t ifd;
+            auto const visit = visit_ifd(mr, nullptr, ifd);
+            if (visit == visit_t::invalid) {
+                return make_error(error_code_t::invalid_ifd, next_ifd_offset);
+            }
+            if (visit == visit_t::skipped) {
+                break;
+            }
             ifds.push_back(std::move(ifd));
         }
         
-        ifd_t exif;
-        ifd_t gps;
+        // Reads the IFD at the index-th offset of the pointer tag, returns an empty IFD if the tag is not recorded or skipped
+        // is_required: an invalid offset is an error, otherwise the IFD is skipped with diagnostic_code_t::value_out_of_range
+        auto read_sub_ifd = [&mr, &visit_ifd](ifd_entry_t const* pointer, size_t const index, bool const is_required) -> result_t<ifd_view_t> {
+            ifd_view_t sub_ifd;
+            if (!pointer || pointer->type() != ifd_tag_type_t::long_ || pointer->count() <= index) {
+                return sub_ifd;
+            }
+            auto const offset_offset = pointer->offset() + 4 * index;
+            // Offsets in the sub IFD are also relative to the TIFF header
+            auto sub_ifd_mr = bb::memory_reader(mr.ptr(), mr.size());
+            sub_ifd_mr.move_to(bb::peek<uint32_t, _ByteOrder>(mr, offset_offset));
+            if (visit_ifd(sub_ifd_mr, pointer, sub_ifd) == visit_t::invalid) {
+                if (is_required) {
+                    return make_error(error_code_t::invalid_ifd, offset_offset);
+                }
+                report_diagnostic(diagnostic_code_t::value_out_of_range, pointer->id(), ifd_tag_type_info(pointer->type()).code, pointer->count());
+            }
+            return sub_ifd;
+        };
+        
+        ifd_view_t exif;
+        ifd_view_t gps;
+        std::vector<ifd_view_t> sub_ifds;
         if (ifds.size() >= 1) {
             static ifd_tag_id_t const exif_ifd_tag_id = 0x8769;
             static ifd_tag_id_t const gps_ifd_tag_id = 0x8825;
-            auto& ifd = ifds[0];
-            if (ifd.count(exif_ifd_tag_id)) {
-                auto& sub_ifd_tag = ifd.at(exif_ifd_tag_id);
-                if (sub_ifd_tag.type() == ifd_tag_type_t::long_) {
-                    auto offset = *sub_ifd_tag.value_ptr<uint32_t const*>();
-                    bb::memory_reader sub_ifd_mr(mr.ptr() + offset, mr.available(offset));
-                    exif = bb::read<ifd_t>(sub_ifd_mr, bo);
+            static ifd_tag_id_t const sub_ifds_tag_id = 0x014A;
+            auto exif_ifd = read_sub_ifd(ifds[0].find(exif_ifd_tag_id), 0, true);
+            if (!exif_ifd) {
+                return bb::make_unexpected(exif_ifd.error());
+            }
+            exif = std::move(*exif_ifd);
+            auto gps_ifd = read_sub_ifd(ifds[0].find(gps_ifd_tag_id), 0, true);
+            if (!gps_ifd) {
+                return bb::make_unexpected(gps_ifd.error());
+            }
+            gps = std::move(*gps_ifd);
+            if (auto pointer = ifds[0].find(sub_ifds_tag_id)) {
+                for (size_t i = 0; i < pointer->count(); ++i) {
+                    if (remaining_ifds == 0) {
+                        // reported once for the rest
+                        report_diagnostic(diagnostic_code_t::budget_exceeded, pointer->id(), ifd_tag_type_info(pointer->type()).code, pointer->count());
+                        break;
+                    }
+                    auto sub_ifd = read_sub_ifd(pointer, i, false);
+                    if (!sub_ifd->empty()) {
+                        sub_ifds.push_back(std::move(*sub_ifd));
+                    }
                 }
             }
-            if (ifd.count(gps_ifd_tag_id)) {
-                auto& sub_ifd_tag = ifd.at(gps_ifd_tag_id);
-                if (sub_ifd_tag.type() == ifd_tag_type_t::long_) {
-                    auto offset = *sub_ifd_tag.value_ptr<uint32_t const*>();
-                    bb::memory_reader sub_ifd_mr(mr.ptr() + offset, mr.available(offset));
-                    gps = bb::read<ifd_t>(sub_ifd_mr, bo);
+        }
+        
+        ifd_view_t interop;
+        ifd_view_t maker_note;
+        if (!exif.empty()) {
+            static ifd_tag_id_t const interop_ifd_tag_id = 0xA005;
+            static ifd_tag_id_t const maker_note_tag_id = 0x927C;
+            interop = std::move(*read_sub_ifd(exif.find(interop_ifd_tag_id), 0, false));
+            
+            // Vendor specific formats (e.g. with a header, or offsets from the MakerNote) are not IFDs of this TIFF
+            auto pointer = exif.find(maker_note_tag_id);
+            if (pointer && pointer->type() == ifd_tag_type_t::undefined && pointer->count() >= 2) {
+                auto const offset = pointer->offset();
+                auto const number_of_ifd_tags = bb::peek<uint16_t, _ByteOrder>(mr, offset);
+                bool is_ifd = number_of_ifd_tags > 0 && 2 + number_of_ifd_tags * sizeof(ifd_tag_t) <= pointer->count();
+                for (size_t ti = 0; is_ifd && ti < number_of_ifd_tags; ++ti) {
+                    is_ifd = ifd_tag_type_info(bb::peek<uint16_t, _ByteOrder>(mr, offset + 2 + ti * sizeof(ifd_tag_t) + 2)).is_supported;
+                }
+                if (is_ifd) {
+                    auto maker_note_mr = bb::memory_reader(mr.ptr(), mr.size());
+                    maker_note_mr.move_to(offset);
+                    visit_ifd(maker_note_mr, pointer, maker_note);
                 }
             }
         }
         
-        std::vector<char> thumbnail;
+        uint8_t const* thumbnail_data = nullptr;
+        size_t thumbnail_size = 0;
         if (ifds.size() >= 2) {
             static ifd_tag_id_t const thumbnail_offset_tag_id = 0x0201; // known as JPEGInterchangeFormat
             static ifd_tag_id_t const thumbnail_length_tag_id = 0x0202; // known as JPEGInterchangeFormatLength
             auto& ifd = ifds[1];
             if (ifd.count(thumbnail_offset_tag_id) && ifd.count(thumbnail_length_tag_id)) {
-                auto& thumbnail_offset_tag = ifd.at(thumbnail_offset_tag_id);
-                auto& thumbnail_length_tag = ifd.at(thumbnail_length_tag_id);
+                auto thumbnail_offset_tag = ifd.at(thumbnail_offset_tag_id);
+                auto thumbnail_length_tag = ifd.at(thumbnail_length_tag_id);
                 if (thumbnail_offset_tag.type() == ifd_tag_type_t::long_ && thumbnail_length_tag.type() == ifd_tag_type_t::long_) {
-                    auto offset = *thumbnail_offset_tag.value_ptr<uint32_t const*>();
-                    auto length = *thumbnail_length_tag.value_ptr<uint32_t const*>();
+                    auto offset = thumbnail_offset_tag.value<uint32_t>();
+                    auto length = thumbnail_length_tag.value<uint32_t>();
                     if (mr.available(offset) >= length) {
-                        thumbnail.resize(length);
-                        mr.peek(offset, reinterpret_cast<uint8_t*>(thumbnail.data()), thumbnail.size());
+                        thumbnail_data = mr.ptr() + offset;
+                        thumbnail_size = length;
                     }
                 }
             }
         }
         
-        return {ifds, exif, gps, thumbnail};
+        return exif_view_t{_ByteOrder, std::move(ifds), std::move(exif), std::move(gps), thumbnail_data, thumbnail_size, std::move(interop), std::move(sub_ifds), std::move(maker_note)};
     }
 }
 
+namespace bbexif {
+    enum class binary_encoding_t {
+        hex, // "ff,d8,..."
+        base64, // "/9j/..."
+        omit, // {"size": 1234}
+        reference, // {"offset": 5678, "size": 1234} of exif_t::thumbnail_location (tag data falls back to omit)
+    };
+    
+    struct json_options_t {
+        binary_encoding_t thumbnail_encoding = binary_encoding_t::hex;
+        binary_encoding_t large_data_encoding = binary_encoding_t::hex; // for tag data larger than large_data_size
+        size_t large_data_size = 64;
+    };
+}
+
 // extension bb::json
 namespace bb {
     template <>
     json_value_object_t make_json(bbexif::ifd_value_t const& value) {
         using namespace bbexif;
         json_value_object_t json;
-        // TODO: improve
+        json.push_back({"type", bb::make_json_value(std::to_string(ifd_tag_type_info(value.type()).code))});
         {
-            {
-                static std::map<ifd_tag_type_t, uint16_t> const ifd_tag_type_map = {
-                    { ifd_tag_type_t::byte, 1 },
-                    { ifd_tag_type_t::ascii, 2 },
-                    { ifd_tag_type_t::short_, 3 },
-                    { ifd_tag_type_t::long_, 4 },
-                    { ifd_tag_type_t::rational, 5 },
-                    { ifd_tag_type_t::undefined, 7 },
-                    { ifd_tag_type_t::slong, 9 },
-                    { ifd_tag_type_t::srational, 10 },
-                };
-                
-                std::stringstream ss;
-                ss << ifd_tag_type_map.at(value.type());
-                json.push_back({"type", bb::make_json_value(ss.str())});
-            }
-            {
-                std::stringstream ss;
-                ss << std::setfill('0') << std::hex;
-                ss << "\"";
-                {
-                    bool is_first = true;
-                    for (auto const& d: value.data()) {
-                        if (!is_first) {
-                            ss << ",";
-                        }
-                        ss << std::setw(2) << (+d < 0 ? d + 256 : +d);
-                        is_first = false;
-                    }
-                }
-                ss << "\"";
-                json.push_back({"data", bb::make_json_value(ss.str())});
-            }
+            std::string data = "\"";
+            bb::append_hex(data, reinterpret_cast<uint8_t const*>(value.data().data()), value.data().size(), ',');
+            data += '"';
+            json.push_back({"data", bb::make_json_value(std::move(data))});
         }
         return json;
     }
@@ -449,9 +1466,10 @@ namespace bb {
     json_value_object_t make_json(bbexif::ifd_t const& ifd) {
         json_value_object_t json;
         for (auto const& value: ifd) {
-            std::stringstream ss;
-            ss << std::setfill('0') << std::hex << std::setw(4) << value.first;
-            json.push_back({ss.str(), bb::make_json_value(bb::make_json(value.second))});
+            std::string key;
+            uint8_t const id[] = { static_cast<uint8_t>(value.first >> 8), static_cast<uint8_t>(value.first) };
+            bb::append_hex(key, id, sizeof(id));
+            json.push_back({std::move(key), bb::make_json_value(bb::make_json(value.second))});
         }
         return json;
     }
@@ -459,7 +1477,7 @@ namespace bb {
     template <>
     json_value_object_t make_json(bbexif::exif_t const& exif) {
         json_value_object_t json;
-
+        
         json_value_array_t ifds;
         for (auto const& ifd: exif.ifds) {
             ifds.push_back(bb::make_json_value(bb::make_json(ifd)));
@@ -467,24 +1485,139 @@ namespace bb {
         json.push_back({"ifd", bb::make_json_value(ifds)});
         json.push_back({"exif", bb::make_json_value(bb::make_json(exif.exif))});
         json.push_back({"gps", bb::make_json_value(bb::make_json(exif.gps))});
-        {
-            std::stringstream ss;
-            ss << std::setfill('0') << std::hex;
-            ss << "\"";
-            {
-                bool is_first = true;
-                for (auto const& d: exif.thumbnail) {
-                    if (!is_first) {
-                        ss << ",";
-                    }
-                    ss << std::setw(2) << (+d < 0 ? d + 256 : +d);
-                    is_first = false;
-                }
+        // only if recorded
+        if (!exif.interop.empty()) {
+            json.push_back({"interop", bb::make_json_value(bb::make_json(exif.interop))});
+        }
+        if (!exif.sub_ifds.empty()) {
+            json_value_array_t sub_ifds;
+            for (auto const& ifd: exif.sub_ifds) {
+                sub_ifds.push_back(bb::make_json_value(bb::make_json(ifd)));
             }
-            ss << "\"";
-            json.push_back({"thumbnail", bb::make_json_value(ss.str())});
+            json.push_back({"sub_ifds", bb::make_json_value(sub_ifds)});
+        }
+        if (!exif.maker_note.empty()) {
+            json.push_back({"maker_note", bb::make_json_value(bb::make_json(exif.maker_note))});
+        }
+        {
+            std::string thumbnail = "\"";
+            bb::append_hex(thumbnail, reinterpret_cast<uint8_t const*>(exif.thumbnail.data()), exif.thumbnail.size(), ',');
+            thumbnail += '"';
+            json.push_back({"thumbnail", bb::make_json_value(std::move(thumbnail))});
         }
         
         return json;
     }
+    
+    inline void write_json_binary(json_writer& writer, char const* ptr, size_t const size, bbexif::binary_encoding_t const encoding) {
+        switch (encoding) {
+            case bbexif::binary_encoding_t::hex:
+            case bbexif::binary_encoding_t::base64: {
+                writer.begin_value();
+                auto& buffer = writer.buffer();
+                buffer += '"';
+                if (encoding == bbexif::binary_encoding_t::hex) {
+                    bb::append_hex(buffer, reinterpret_cast<uint8_t const*>(ptr), size, ',');
+                }
+                else {
+                    bb::append_base64(buffer, reinterpret_cast<uint8_t const*>(ptr), size);
+                }
+                buffer += '"';
+                break;
+            }
+            case bbexif::binary_encoding_t::omit:
+            case bbexif::binary_encoding_t::reference:
+                writer.begin_object();
+                writer.key("size", 4);
+                writer.number(size);
+                writer.end_object();
+                break;
+        }
+    }
+    
+    void write_json(json_writer& writer, bbexif::ifd_value_t const& value, bbexif::json_options_t const& options) {
+        writer.begin_object();
+        writer.key("type", 4);
+        writer.number(bbexif::ifd_tag_type_info(value.type()).code);
+        writer.key("data", 4);
+        auto const size = value.data().size();
+        write_json_binary(writer, value.data().data(), size, size > options.large_data_size ? options.large_data_encoding : bbexif::binary_encoding_t::hex);
+        writer.end_object();
+    }
+    
+    void write_json(json_writer& writer, bbexif::ifd_t const& ifd, bbexif::json_options_t const& options) {
+        auto const& table = bb::hex_table();
+        writer.begin_object();
+        for (auto const& value: ifd) {
+            char key[4];
+            std::memcpy(key, table.digits[value.first >> 8], 2);
+            std::memcpy(key + 2, table.digits[value.first & 0xFF], 2);
+            writer.key(key, sizeof(key));
+            write_json(writer, value.second, options);
+        }
+        writer.end_object();
+    }
+    
+    void write_json(json_writer& writer, bbexif::exif_t const& exif, bbexif::json_options_t const& options) {
+        writer.begin_object();
+        writer.key("ifd", 3);
+        writer.begin_array();
+        for (auto const& ifd: exif.ifds) {
+            write_json(writer, ifd, options);
+        }
+        writer.end_array();
+        writer.key("exif", 4);
+        write_json(writer, exif.exif, options);
+        writer.key("gps", 3);
+        write_json(writer, exif.gps, options);
+        // only if recorded
+        if (!exif.interop.empty()) {
+            writer.key("interop", 7);
+            write_json(writer, exif.interop, options);
+        }
+        if (!exif.sub_ifds.empty()) {
+            writer.key("sub_ifds", 8);
+            writer.begin_array();
+            for (auto const& ifd: exif.sub_ifds) {
+                write_json(writer, ifd, options);
+            }
+            writer.end_array();
+        }
+        if (!exif.maker_note.empty()) {
+            writer.key("maker_note", 10);
+            write_json(writer, exif.maker_note, options);
+        }
+        writer.key("thumbnail", 9);
+        if (options.thumbnail_encoding == bbexif::binary_encoding_t::reference) {
+            writer.begin_object();
+            writer.key("offset", 6);
+            writer.number(exif.thumbnail_location.offset);
+            writer.key("size", 4);
+            writer.number(exif.thumbnail_location.size);
+            writer.end_object();
+        }
+        else if (options.thumbnail_encoding == bbexif::binary_encoding_t::omit) {
+            // the thumbnail may not be copied, see read_options_t
+            write_json_binary(writer, nullptr, exif.thumbnail.empty() ? exif.thumbnail_location.size : exif.thumbnail.size(), options.thumbnail_encoding);
+        }
+        else {
+            write_json_binary(writer, exif.thumbnail.data(), exif.thumbnail.size(), options.thumbnail_encoding);
+        }
+        writer.end_object();
+    }
+    
+    template <>
+    void write_json(json_writer& writer, bbexif::ifd_value_t const& value) {
+        write_json(writer, value, bbexif::json_options_t());
+    }
+    
+    template <>
+    void write_json(json_writer& writer, bbexif::ifd_t const& ifd) {
+        write_json(writer, ifd, bbexif::json_options_t());
+    }
+    
+    template <>
+    void write_json(json_writer& writer, bbexif::exif_t const& exif) {
+        write_json(writer, exif, bbexif::json_options_t());
+    }
 }
@@ -0,0 +1,154 @@
+//
+//  bbexif_batch.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ Reads Exif of many files (or buffers) in parallel:
+ - each item is parsed on a worker of bb::thread_pool, and does not share state with others
+ - an error of an item is recorded in its result, and does not stop the batch
+ - results are in the same order as inputs, or passed to a callback as soon as each item is completed
+``` */
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bb/thread_pool.hpp"
+#include "bbexif.hpp"
+
+namespace bbexif {
+    struct batch_options_t {
+        size_t number_of_threads = 0; // 0 means std::thread::hardware_concurrency()
+        file_access_t access = file_access_t::mmap;
+        bb::thread_pool* pool = nullptr; // if specified, used instead of creating one (number_of_threads is ignored)
+    };
+    
+    struct batch_result_t {
+        bool is_succeeded_ = false;
+        exif_t exif_;
+        std::string error_; // error_t::message() of the failed read
+        
+        inline bool is_succeeded() const {
+            return is_succeeded_;
+        }
+        
+        inline exif_t const& exif() const {
+            return exif_;
+        }
+        
+        inline exif_t& exif() {
+            return exif_;
+        }
+        
+        inline std::string const& error() const {
+            return error_;
+        }
+    };
+    
+    // buffer: [ptr, ptr + size) of a JPEG file
+    using batch_buffer_t = std::pair<char const*, size_t>;
+    
+    // on_completed: called on worker threads, in the order of completion
+    using batch_callback_t = std::function<void(size_t const index, batch_result_t&& result)>;
+    
+    std::vector<batch_result_t> read_exif_batch(std::vector<std::string> const& filepaths, batch_options_t const& options = batch_options_t());
+    void read_exif_batch(std::vector<std::string> const& filepaths, batch_options_t const& options, batch_callback_t const& on_completed);
+    std::vector<batch_result_t> read_exif_batch(std::vector<batch_buffer_t> const& buffers, batch_options_t const& options = batch_options_t());
+    void read_exif_batch(std::vector<batch_buffer_t> const& buffers, batch_options_t const& options, batch_callback_t const& on_completed);
+    template <typename _Read>
+    void run_batch(size_t const count, batch_options_t const& options, _Read read, batch_callback_t const& on_completed);
+    
+    std::vector<batch_result_t> read_exif_batch(std::vector<std::string> const& filepaths, batch_options_t const& options) {
+        std::vector<batch_result_t> results(filepaths.size());
+        read_exif_batch(filepaths, options, [&results](size_t const index, batch_result_t&& result) {
+            results[index] = std::move(result);
+        });
+        return results;
+    }
+    
+    void read_exif_batch(std::vector<std::string> const& filepaths, batch_options_t const& options, batch_callback_t const& on_completed) {
+        auto const access = options.access;
+        run_batch(filepaths.size(), options, [&filepaths, access](size_t const index) {
+            return try_read_exif(filepaths[index], access);
+        }, on_completed);
+    }
+    
+    // The buffers must not be changed until the batch is completed
+    std::vector<batch_result_t> read_exif_batch(std::vector<batch_buffer_t> const& buffers, batch_options_t const& options) {
+        std::vector<batch_result_t> results(buffers.size());
+        read_exif_batch(buffers, options, [&results](size_t const index, batch_result_t&& result) {
+            results[index] = std::move(result);
+        });
+        return results;
+    }
+    
+    void read_exif_batch(std::vector<batch_buffer_t> const& buffers, batch_options_t const& options, batch_callback_t const& on_completed) {
+        run_batch(buffers.size(), options, [&buffers](size_t const index) {
+            return try_read_exif_from_jpeg(buffers[index].first, buffers[index].second);
+        }, on_completed);
+    }
+    
+    // read: size_t -> result_t<exif_t>, failures are returned rather than thrown
+    // Returns after all items are completed
+    template <typename _Read>
+    void run_batch(size_t const count, batch_options_t const& options, _Read read, batch_callback_t const& on_completed) {
+        std::unique_ptr<bb::thread_pool> own_pool;
+        auto pool = options.pool;
+        if (!pool) {
+            own_pool.reset(new bb::thread_pool(options.number_of_threads));
+            pool = own_pool.get();
+        }
+        
+        // waits only for this batch, the pool may be shared with others
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t remaining = count;
+        for (size_t i = 0; i < count; ++i) {
+            pool->submit([&, i]() {
+                batch_result_t result;
+                try {
+                    auto exif = read(i);
+                    if (exif) {
+                        result.exif_ = std::move(exif).value();
+                        result.is_succeeded_ = true;
+                    }
+                    else {
+                        result.error_ = exif.error().message();
+                    }
+                }
+                catch (std::exception const& e) {
+                    result.error_ = e.what();
+                }
+                catch (...) {
+                    result.error_ = "Unknown error";
+                }
+                try {
+                    on_completed(i, std::move(result));
+                }
+                catch (...) {
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--remaining == 0) {
+                    cv.notify_all();
+                }
+            });
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&remaining]() {
+            return remaining == 0;
+        });
+    }
+}
@@ -0,0 +1,308 @@
+//
+//  bbexif_cache.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ In-process cache of exif_t in front of read_exif(), for services reading the same files repeatedly:
+ - entries are identified by (dev, inode) of fstat() on the opened file, and invalidated if the size or the mtime is changed
+ - a miss parses the same opened file, so the entry never holds the data of another file (e.g. replaced by rename() meanwhile)
+ - the capacity is in bytes, estimated from tag data and thumbnails, see estimate_exif_size()
+ - shards have their own locks, a hit takes only the shared lock of its shard
+ - eviction is CLOCK (second chance), an approximation of LRU which does not reorder entries on hits
+ - failed reads are not cached
+ - files are read with pread() by default, since cached files may be rewritten (e.g. truncated by editors) while the service reads them
+``` */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bb/mapped_file.hpp"
+#include "bbexif.hpp"
+
+namespace bbexif {
+    struct cache_key_t {
+        uint64_t dev;
+        uint64_t inode;
+        uint64_t file_size; // to detect modifications
+        int64_t mtime; // nanoseconds since the epoch, to detect modifications
+    };
+    
+    struct cache_options_t {
+        size_t capacity = 64 * 1024 * 1024; // bytes, divided into shards
+        size_t number_of_shards = 16;
+        file_access_t access = file_access_t::prefix; // mmap raises SIGBUS if the file is truncated while it is read
+        read_options_t read_options;
+    };
+    
+    struct cache_stats_t {
+        size_t hits;
+        size_t misses;
+        size_t evictions; // by the capacity
+        size_t invalidations; // by modifications of files
+        size_t number_of_entries;
+        size_t size; // bytes
+    };
+    
+    struct exif_cache_t {
+        struct entry_t {
+            cache_key_t key_;
+            std::shared_ptr<exif_t const> exif_;
+            size_t size_;
+            std::atomic<bool> is_referenced_; // set on hits, cleared by the clock hand
+            
+            entry_t(cache_key_t const& key, std::shared_ptr<exif_t const> exif, size_t const size)
+            : key_(key), exif_(std::move(exif)), size_(size), is_referenced_(false) {
+            }
+        };
+        
+        struct file_id_hash {
+            inline size_t operator()(std::pair<uint64_t, uint64_t> const& id) const {
+                return std::hash<uint64_t>()(id.first * 0x9E3779B97F4A7C15ull ^ id.second);
+            }
+        };
+        
+        struct shard_t {
+            std::shared_timed_mutex mutex_;
+            std::list<entry_t> entries_; // in the order of the clock
+            std::unordered_map<std::pair<uint64_t, uint64_t>, std::list<entry_t>::iterator, file_id_hash> index_; // by (dev, inode)
+            std::list<entry_t>::iterator hand_ = entries_.end();
+            size_t size_ = 0;
+            // counters of each shard, not to share a cache line between all hits
+            std::atomic<size_t> hits_{0};
+            std::atomic<size_t> misses_{0};
+            std::atomic<size_t> evictions_{0};
+            std::atomic<size_t> invalidations_{0};
+        };
+        
+        cache_options_t options_;
+        size_t shard_capacity_;
+        std::vector<std::unique_ptr<shard_t>> shards_;
+        
+        explicit exif_cache_t(cache_options_t const& options = cache_options_t());
+        
+        exif_cache_t(exif_cache_t const&) = delete;
+        exif_cache_t const& operator=(exif_cache_t const&) = delete;
+        
+        // Reads the file on a miss, throws as read_exif()
+        // The returned exif_t is kept alive after evicted
+        std::shared_ptr<exif_t const> get(std::string const& filepath);
+        void invalidate(std::string const& filepath);
+        void clear();
+        cache_stats_t stats();
+        
+        inline shard_t& shard(cache_key_t const& key) {
+            return *shards_[file_id_hash()({key.dev, key.inode}) % shards_.size()];
+        }
+        
+        // shard: must be locked exclusively
+        void erase(shard_t& shard, std::list<entry_t>::iterator it);
+        void insert(shard_t& shard, cache_key_t const& key, std::shared_ptr<exif_t const> exif, size_t const size);
+    };
+    
+    // An opened file, to take the key of and to read the same file
+    struct cache_file_t {
+        int fd_ = -1;
+        
+        explicit cache_file_t(char const* filepath);
+        
+        cache_file_t(cache_file_t const&) = delete;
+        cache_file_t const& operator=(cache_file_t const&) = delete;
+        
+        ~cache_file_t();
+        
+        // Returns false if the file is not a regular file (e.g. not found, pipe), then it is not cached
+        bool stat(cache_key_t& key) const;
+    };
+    
+    size_t estimate_exif_size(exif_t const& exif);
+    
+    exif_cache_t::exif_cache_t(cache_options_t const& options)
+    : options_(options) {
+        if (options_.number_of_shards == 0) {
+            options_.number_of_shards = 1;
+        }
+        shard_capacity_ = options_.capacity / options_.number_of_shards;
+        for (size_t i = 0; i < options_.number_of_shards; ++i) {
+            shards_.emplace_back(new shard_t());
+        }
+    }
+    
+    std::shared_ptr<exif_t const> exif_cache_t::get(std::string const& filepath) {
+        cache_file_t file(filepath.c_str());
+        cache_key_t key;
+        if (!file.stat(key)) {
+            // e.g. not found, pipe
+            ++shards_.front()->misses_;
+            return std::make_shared<exif_t const>(read_exif(filepath, options_.access, options_.read_options));
+        }
+        auto& shard = this->shard(key);
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(shard.mutex_);
+            auto it = shard.index_.find({key.dev, key.inode});
+            if (it != shard.index_.end() && it->second->key_.file_size == key.file_size && it->second->key_.mtime == key.mtime) {
+                it->second->is_referenced_.store(true, std::memory_order_relaxed);
+                ++shard.hits_;
+                return it->second->exif_;
+            }
+        }
+        ++shard.misses_;
+        
+        // without locking, other files in the shard are not blocked
+        auto exif = std::make_shared<exif_t const>(value_or_throw(try_read_exif(file.fd_, options_.access, options_.read_options), filepath));
+        auto const size = estimate_exif_size(*exif);
+        std::lock_guard<std::shared_timed_mutex> lock(shard.mutex_);
+        auto it = shard.index_.find({key.dev, key.inode});
+        if (it != shard.index_.end()) {
+            // modified, or read by another thread at the same time
+            if (it->second->key_.file_size != key.file_size || it->second->key_.mtime != key.mtime) {
+                ++shard.invalidations_;
+            }
+            erase(shard, it->second);
+        }
+        if (size <= shard_capacity_) {
+            insert(shard, key, exif, size);
+        }
+        return exif;
+    }
+    
+    void exif_cache_t::invalidate(std::string const& filepath) {
+        // a file which can not be opened is not cached either
+        cache_file_t file(filepath.c_str());
+        cache_key_t key;
+        if (!file.stat(key)) {
+            return;
+        }
+        auto& shard = this->shard(key);
+        std::lock_guard<std::shared_timed_mutex> lock(shard.mutex_);
+        auto it = shard.index_.find({key.dev, key.inode});
+        if (it != shard.index_.end()) {
+            erase(shard, it->second);
+            ++shard.invalidations_;
+        }
+    }
+    
+    void exif_cache_t::clear() {
+        for (auto& shard: shards_) {
+            std::lock_guard<std::shared_timed_mutex> lock(shard->mutex_);
+            shard->index_.clear();
+            shard->entries_.clear();
+            shard->hand_ = shard->entries_.end();
+            shard->size_ = 0;
+        }
+    }
+    
+    cache_stats_t exif_cache_t::stats() {
+        cache_stats_t stats{0, 0, 0, 0, 0, 0};
+        for (auto& shard: shards_) {
+            stats.hits += shard->hits_.load();
+            stats.misses += shard->misses_.load();
+            stats.evictions += shard->evictions_.load();
+            stats.invalidations += shard->invalidations_.load();
+            std::shared_lock<std::shared_timed_mutex> lock(shard->mutex_);
+            stats.number_of_entries += shard->entries_.size();
+            stats.size += shard->size_;
+        }
+        return stats;
+    }
+    
+    void exif_cache_t::erase(shard_t& shard, std::list<entry_t>::iterator it) {
+        if (shard.hand_ == it) {
+            ++shard.hand_;
+        }
+        shard.size_ -= it->size_;
+        shard.index_.erase({it->key_.dev, it->key_.inode});
+        shard.entries_.erase(it);
+    }
+    
+    void exif_cache_t::insert(shard_t& shard, cache_key_t const& key, std::shared_ptr<exif_t const> exif, size_t const size) {
+        while (shard.size_ + size > shard_capacity_ && !shard.entries_.empty()) {
+            if (shard.hand_ == shard.entries_.end()) {
+                shard.hand_ = shard.entries_.begin();
+            }
+            if (shard.hand_->is_referenced_.exchange(false, std::memory_order_relaxed)) {
+                // second chance
+                ++shard.hand_;
+                continue;
+            }
+            erase(shard, shard.hand_);
+            ++shard.evictions_;
+        }
+        // behind the hand, i.e. visited last
+        auto it = shard.entries_.emplace(shard.hand_, key, std::move(exif), size);
+        shard.index_.emplace(std::make_pair(key.dev, key.inode), it);
+        shard.size_ += size;
+    }
+    
+    cache_file_t::cache_file_t(char const* filepath) {
+#if BB_MAPPED_FILE_AVAILABLE
+        fd_ = ::open(filepath, O_RDONLY);
+#else
+        (void)filepath;
+#endif
+    }
+    
+    cache_file_t::~cache_file_t() {
+#if BB_MAPPED_FILE_AVAILABLE
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+#endif
+    }
+    
+    bool cache_file_t::stat(cache_key_t& key) const {
+#if BB_MAPPED_FILE_AVAILABLE
+        struct stat st;
+        if (fd_ < 0 || ::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode)) {
+            return false;
+        }
+#if defined(__APPLE__)
+        auto const& mtime = st.st_mtimespec;
+#else
+        auto const& mtime = st.st_mtim;
+#endif
+        key = {static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino), static_cast<uint64_t>(st.st_size), static_cast<int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec};
+        return true;
+#else
+        (void)key;
+        return false;
+#endif
+    }
+    
+    // Bytes of tag data, the thumbnail and the containers of exif, for the capacity of exif_cache_t
+    size_t estimate_exif_size(exif_t const& exif) {
+        size_t size = sizeof(exif_t) + sizeof(exif_cache_t::entry_t) + exif.thumbnail.size();
+        auto add_ifd = [&size](ifd_t const& ifd) {
+            size += sizeof(ifd_t) + ifd.size() * sizeof(ifd_t::value_type);
+            for (auto const& tag: ifd) {
+                size += tag.second.data().size();
+            }
+        };
+        for (auto const& ifd: exif.ifds) {
+            add_ifd(ifd);
+        }
+        add_ifd(exif.exif);
+        add_ifd(exif.gps);
+        add_ifd(exif.interop);
+        for (auto const& ifd: exif.sub_ifds) {
+            add_ifd(ifd);
+        }
+        add_ifd(exif.maker_note);
+        return size;
+    }
+}
@@ -0,0 +1,624 @@
+//
+//  bbexif_index.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ Persistent index of parsed Exif, to avoid parsing files again (e.g. on restarts of a service):
+ - a record for each file, keyed by the path, and with the size, the mtime and the inode to detect modifications
+ - IFD entries and values are recorded in a fixed layout in the native byte order, so the index is used through mmap without deserialization
+ - update_index() parses only new or modified files, and reuses the others from the current index
+ - the index is replaced atomically by rename(), so any number of processes can read it while it is updated (readers keep the old one until they open it again)
+ - updates are serialized by flock() on "<index>.lock"
+ 
+ Layout (offsets are from the beginning of the index, and aligned to 8 bytes):
+ | Section | Contents                                                                      |
+ |---------|-------------------------------------------------------------------------------|
+ | header  | index_header_t                                                                |
+ | data    | paths, values, index_entry_t arrays (sorted by id) and index_ifd_record_t arrays |
+ | records | index_record_t array, sorted by path                                          |
+``` */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bb/mapped_file.hpp"
+#include "bb/scope_exit.hpp"
+#include "bb/string_view.hpp"
+#include "bb/thread_pool.hpp"
+#include "bbexif.hpp"
+#include "bbexif_tags.hpp"
+
+#if BB_MAPPED_FILE_AVAILABLE
+#include <sys/file.h>
+#endif
+
+namespace bbexif {
+    // Identifies the content of a file without reading it
+    struct index_key_t {
+        uint64_t file_size;
+        int64_t mtime; // nanoseconds since the epoch
+        uint64_t inode;
+    };
+    
+    inline bool operator==(index_key_t const& lhs, index_key_t const& rhs) {
+        return lhs.file_size == rhs.file_size && lhs.mtime == rhs.mtime && lhs.inode == rhs.inode;
+    }
+    
+    inline bool operator!=(index_key_t const& lhs, index_key_t const& rhs) {
+        return !(lhs == rhs);
+    }
+    
+    // on-disk layout
+    
+    constexpr char index_magic[8] = {'B', 'B', 'E', 'X', 'I', 'D', 'X', '\0'};
+    constexpr uint32_t index_version = 1; // also detects an index in the other byte order
+    
+    struct index_header_t {
+        char magic_[8];
+        uint32_t version_;
+        uint32_t number_of_records_;
+        uint64_t records_offset_;
+        uint64_t size_; // of the index, to detect truncation
+    };
+    
+    struct index_record_t {
+        uint64_t path_offset_;
+        uint32_t path_size_;
+        uint32_t number_of_ifds_;
+        uint64_t ifds_offset_; // to index_ifd_record_t[number_of_ifds_]
+        index_key_t key_;
+        uint64_t thumbnail_offset_;
+        uint64_t thumbnail_size_;
+        uint32_t error_code_; // error_code_t::none if the file has Exif
+        uint32_t reserved_;
+        uint64_t error_offset_;
+        
+        inline index_key_t const& key() const { return key_; }
+        inline bool has_exif() const { return error_code_ == static_cast<uint32_t>(error_code_t::none); }
+        inline error_t error() const { return {static_cast<error_code_t>(error_code_), error_offset_}; }
+    };
+    
+    enum class index_ifd_kind_t : uint32_t {
+        ifd, // exif_t::ifds, in order
+        exif,
+        gps,
+        interop,
+        sub_ifd, // exif_t::sub_ifds, in order
+        maker_note,
+    };
+    
+    struct index_ifd_record_t {
+        uint32_t kind_; // index_ifd_kind_t
+        uint32_t number_of_entries_;
+        uint64_t entries_offset_; // to index_entry_t[number_of_entries_]
+    };
+    
+    struct index_entry_t {
+        ifd_tag_id_t id_;
+        uint16_t type_; // code recorded in files
+        uint32_t count_;
+        uint64_t offset_; // to value(s) in the native byte order
+        
+        inline ifd_tag_id_t id() const { return id_; }
+        inline ifd_tag_type_t type() const { return ifd_tag_type_info(type_).type; }
+        inline uint32_t count() const { return count_; }
+        inline uint64_t offset() const { return offset_; }
+    };
+    
+    static_assert(sizeof(index_header_t) == 32 && sizeof(index_record_t) == 80 && sizeof(index_ifd_record_t) == 16 && sizeof(index_entry_t) == 16, "The layout of the index must not depend on the platform");
+    
+    // views of the index
+    
+    // Same accessors as ifd_view_t, values are in the native byte order
+    struct index_ifd_view_t {
+        uint8_t const* ptr_ = nullptr; // the index
+        index_entry_t const* entries_ = nullptr; // sorted by id
+        size_t size_ = 0;
+        
+        inline index_entry_t const* begin() const { return entries_; }
+        inline index_entry_t const* end() const { return entries_ + size_; }
+        inline size_t size() const { return size_; }
+        inline bool empty() const { return size_ == 0; }
+        
+        inline index_entry_t const* find(ifd_tag_id_t const id) const {
+            auto it = std::lower_bound(begin(), end(), id, [](index_entry_t const& entry, ifd_tag_id_t const id) {
+                return entry.id() < id;
+            });
+            if (it == end() || it->id() != id) {
+                return nullptr;
+            }
+            return it;
+        }
+        
+        inline size_t count(ifd_tag_id_t const id) const {
+            return find(id) ? 1 : 0;
+        }
+        
+        inline ifd_value_view_t at(ifd_tag_id_t const id) const {
+            auto entry = find(id);
+            if (!entry) {
+                throw std::out_of_range(bb_trace_message("IFD tag not found: id=0x%04X", id));
+            }
+            return value(*entry);
+        }
+        
+        inline ifd_value_view_t value(index_entry_t const& entry) const {
+            auto const size = entry.count() * ifd_tag_type_size(entry.type());
+            return {entry.type(), entry.count(), ptr_ + entry.offset(), size, bb::byte_order_t::native};
+        }
+    };
+    
+    // Same members as exif_t (except the thumbnail, see thumbnail_location), refers to the index
+    struct index_exif_t {
+        std::vector<index_ifd_view_t> ifds;
+        index_ifd_view_t exif;
+        index_ifd_view_t gps;
+        thumbnail_location_t thumbnail_location;
+        index_ifd_view_t interop;
+        std::vector<index_ifd_view_t> sub_ifds;
+        index_ifd_view_t maker_note;
+    };
+    
+    // Read-only mapping of an index, can be shared between threads
+    struct exif_index_t {
+        bb::mapped_file file_;
+        index_record_t const* records_ = nullptr;
+        size_t size_ = 0;
+        
+        exif_index_t() noexcept {
+        }
+        
+        exif_index_t(exif_index_t const&) = delete;
+        exif_index_t const& operator=(exif_index_t const&) = delete;
+        
+        // Returns false if the index is not found or not valid, then nothing is opened
+        bool open(char const* filepath) noexcept;
+        
+        inline void close() noexcept {
+            file_.close();
+            records_ = nullptr;
+            size_ = 0;
+        }
+        
+        inline bool is_open() const noexcept {
+            return file_.is_open();
+        }
+        
+        // records, sorted by path
+        inline index_record_t const* begin() const { return records_; }
+        inline index_record_t const* end() const { return records_ + size_; }
+        inline size_t size() const { return size_; }
+        
+        inline bb::string_view path(index_record_t const& record) const {
+            return {reinterpret_cast<char const*>(file_.ptr() + record.path_offset_), record.path_size_};
+        }
+        
+        // Returns nullptr if not found, the record may be out of date, see index_record_t::key()
+        index_record_t const* find(std::string const& filepath) const;
+        // The error of the record if the file has no Exif, or error_code_t::invalid_ifd if the record is broken
+        result_t<index_exif_t> exif(index_record_t const& record) const;
+        
+        // Returns false if any of the ranges is out of the index
+        inline bool contains(uint64_t const offset, uint64_t const count, size_t const size) const {
+            return offset % 8 == 0 && offset <= file_.size() && count <= (file_.size() - offset) / size;
+        }
+    };
+    
+    // Builds an index in memory, and writes it at once
+    struct index_builder_t {
+        std::vector<uint8_t> data_; // following the header
+        std::vector<index_record_t> records_;
+        
+        void add(std::string const& filepath, index_key_t const& key, exif_t const& exif);
+        void add(std::string const& filepath, index_key_t const& key, index_exif_t const& exif);
+        void add(std::string const& filepath, index_key_t const& key, error_t const& error);
+        // Replaces the file atomically
+        void write(std::string const& filepath);
+        
+        // Returns the offset in the index, aligned to 8 bytes
+        inline uint64_t append(void const* ptr, size_t const size) {
+            data_.resize((data_.size() + 7) / 8 * 8);
+            auto const offset = sizeof(index_header_t) + data_.size();
+            data_.insert(data_.end(), static_cast<uint8_t const*>(ptr), static_cast<uint8_t const*>(ptr) + size);
+            return offset;
+        }
+        
+        index_record_t make_record(std::string const& filepath, index_key_t const& key);
+        template <typename _Exif>
+        void add_exif(std::string const& filepath, index_key_t const& key, _Exif const& exif);
+        index_ifd_record_t append_ifd(index_ifd_kind_t const kind, ifd_t const& ifd);
+        index_ifd_record_t append_ifd(index_ifd_kind_t const kind, index_ifd_view_t const& ifd);
+    };
+    
+    struct index_options_t {
+        size_t number_of_threads = 0; // 0 means std::thread::hardware_concurrency()
+        file_access_t access = file_access_t::prefix; // files may be truncated while read, which raises SIGBUS on a mapping
+        read_options_t read_options; // the thumbnail is not copied anyway
+    };
+    
+    struct index_stats_t {
+        size_t number_of_parsed = 0; // new or modified files
+        size_t number_of_reused = 0; // from the current index
+        size_t number_of_failed = 0; // not indexed, e.g. removed while updating
+    };
+    
+    bool stat_index_key(char const* filepath, index_key_t& key);
+    index_stats_t update_index(std::string const& index_filepath, std::vector<std::string> const& filepaths);
+    index_stats_t update_index(std::string const& index_filepath, std::vector<std::string> const& filepaths, index_options_t const& options);
+    ifd_t make_ifd(index_ifd_view_t const& view);
+    exif_t make_exif(index_exif_t const& view);
+    template <typename _Tag>
+    bb::optional<tag_value_t<_Tag>> get(index_ifd_view_t const& ifd);
+    template <typename _Tag, ifd_kind_t _Ifd = _Tag::ifd>
+    bb::optional<tag_value_t<_Tag>> get(index_exif_t const& exif);
+    
+    bool exif_index_t::open(char const* filepath) noexcept {
+        close();
+        if (!file_.open(filepath) || file_.size() < sizeof(index_header_t)) {
+            close();
+            return false;
+        }
+        auto const header = reinterpret_cast<index_header_t const*>(file_.ptr());
+        if (std::memcmp(header->magic_, index_magic, sizeof(index_magic)) != 0 || header->version_ != index_version || header->size_ != file_.size() || !contains(header->records_offset_, header->number_of_records_, sizeof(index_record_t))) {
+            close();
+            return false;
+        }
+        records_ = reinterpret_cast<index_record_t const*>(file_.ptr() + header->records_offset_);
+        size_ = header->number_of_records_;
+        // paths are used by find(), the rest is checked by exif()
+        for (auto const& record: *this) {
+            if (record.path_offset_ > file_.size() || record.path_size_ > file_.size() - record.path_offset_) {
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    index_record_t const* exif_index_t::find(std::string const& filepath) const {
+        auto const key = bb::string_view(filepath);
+        auto it = std::lower_bound(begin(), end(), key, [this](index_record_t const& record, bb::string_view const& key) {
+            auto const record_path = path(record);
+            auto const result = std::memcmp(record_path.data(), key.data(), std::min(record_path.size(), key.size()));
+            return result < 0 || (result == 0 && record_path.size() < key.size());
+        });
+        if (it == end() || path(*it) != key) {
+            return nullptr;
+        }
+        return it;
+    }
+    
+    result_t<index_exif_t> exif_index_t::exif(index_record_t const& record) const {
+        if (!record.has_exif()) {
+            return bb::make_unexpected(record.error());
+        }
+        index_exif_t exif;
+        exif.thumbnail_location = {record.thumbnail_offset_, static_cast<size_t>(record.thumbnail_size_)};
+        if (!contains(record.ifds_offset_, record.number_of_ifds_, sizeof(index_ifd_record_t))) {
+            return make_error(error_code_t::invalid_ifd, 0);
+        }
+        auto const ifd_records = reinterpret_cast<index_ifd_record_t const*>(file_.ptr() + record.ifds_offset_);
+        for (size_t i = 0; i < record.number_of_ifds_; ++i) {
+            auto const& ifd_record = ifd_records[i];
+            if (!contains(ifd_record.entries_offset_, ifd_record.number_of_entries_, sizeof(index_entry_t))) {
+                return make_error(error_code_t::invalid_ifd, 0);
+            }
+            index_ifd_view_t ifd{file_.ptr(), reinterpret_cast<index_entry_t const*>(file_.ptr() + ifd_record.entries_offset_), ifd_record.number_of_entries_};
+            for (auto const& entry: ifd) {
+                if (!ifd_tag_type_info(entry.type_).is_supported || !contains(entry.offset(), entry.count(), ifd_tag_type_size(entry.type()))) {
+                    return make_error(error_code_t::invalid_ifd, 0);
+                }
+            }
+            switch (static_cast<index_ifd_kind_t>(ifd_record.kind_)) {
+                case index_ifd_kind_t::ifd:
+                    exif.ifds.push_back(ifd);
+                    break;
+                case index_ifd_kind_t::exif:
+                    exif.exif = ifd;
+                    break;
+                case index_ifd_kind_t::gps:
+                    exif.gps = ifd;
+                    break;
+                case index_ifd_kind_t::interop:
+                    exif.interop = ifd;
+                    break;
+                case index_ifd_kind_t::sub_ifd:
+                    exif.sub_ifds.push_back(ifd);
+                    break;
+                case index_ifd_kind_t::maker_note:
+                    exif.maker_note = ifd;
+                    break;
+                default:
+                    return make_error(error_code_t::invalid_ifd, 0);
+            }
+        }
+        return exif;
+    }
+    
+    void index_builder_t::add(std::string const& filepath, index_key_t const& key, exif_t const& exif) {
+        add_exif(filepath, key, exif);
+    }
+    
+    void index_builder_t::add(std::string const& filepath, index_key_t const& key, index_exif_t const& exif) {
+        add_exif(filepath, key, exif);
+    }
+    
+    void index_builder_t::add(std::string const& filepath, index_key_t const& key, error_t const& error) {
+        auto record = make_record(filepath, key);
+        record.error_code_ = static_cast<uint32_t>(error.code());
+        record.error_offset_ = error.offset();
+        records_.push_back(record);
+    }
+    
+    void index_builder_t::write(std::string const& filepath) {
+        std::sort(records_.begin(), records_.end(), [this](index_record_t const& lhs, index_record_t const& rhs) {
+            auto const lhs_path = data_.data() + (lhs.path_offset_ - sizeof(index_header_t));
+            auto const rhs_path = data_.data() + (rhs.path_offset_ - sizeof(index_header_t));
+            auto const result = std::memcmp(lhs_path, rhs_path, std::min(lhs.path_size_, rhs.path_size_));
+            return result < 0 || (result == 0 && lhs.path_size_ < rhs.path_size_);
+        });
+        
+        index_header_t header;
+        std::memcpy(header.magic_, index_magic, sizeof(index_magic));
+        header.version_ = index_version;
+        header.number_of_records_ = static_cast<uint32_t>(records_.size());
+        auto const padding = (8 - data_.size() % 8) % 8;
+        header.records_offset_ = sizeof(index_header_t) + data_.size() + padding;
+        header.size_ = header.records_offset_ + records_.size() * sizeof(index_record_t);
+        
+        // readers of the current index are not affected
+        auto const temporary_filepath = filepath + ".tmp";
+        auto file = std::fopen(temporary_filepath.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error(bb_trace_message("Unable to open the file: %s", temporary_filepath.c_str()));
+        }
+        auto remove_file = bb::make_scope_exit([&file, &temporary_filepath]() {
+            if (file) {
+                std::fclose(file);
+                std::remove(temporary_filepath.c_str());
+            }
+        });
+        uint8_t const zeros[8] = {};
+        bool is_written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        is_written = is_written && std::fwrite(data_.data(), 1, data_.size(), file) == data_.size();
+        is_written = is_written && std::fwrite(zeros, 1, padding, file) == padding;
+        is_written = is_written && std::fwrite(records_.data(), sizeof(index_record_t), records_.size(), file) == records_.size();
+        is_written = is_written && std::fflush(file) == 0;
+#if BB_MAPPED_FILE_AVAILABLE
+        // the content must be on the disk before the rename
+        is_written = is_written && ::fsync(::fileno(file)) == 0;
+#endif
+        if (!is_written) {
+            throw std::runtime_error(bb_trace_message("Unable to write the file: %s", temporary_filepath.c_str()));
+        }
+        std::fclose(file);
+        file = nullptr;
+        if (std::rename(temporary_filepath.c_str(), filepath.c_str()) != 0) {
+            std::remove(temporary_filepath.c_str());
+            throw std::runtime_error(bb_trace_message("Unable to write the file: %s", filepath.c_str()));
+        }
+    }
+    
+    index_record_t index_builder_t::make_record(std::string const& filepath, index_key_t const& key) {
+        index_record_t record{};
+        record.path_offset_ = append(filepath.data(), filepath.size());
+        record.path_size_ = static_cast<uint32_t>(filepath.size());
+        record.key_ = key;
+        record.error_code_ = static_cast<uint32_t>(error_code_t::none);
+        return record;
+    }
+    
+    // _Exif: exif_t or index_exif_t
+    template <typename _Exif>
+    void index_builder_t::add_exif(std::string const& filepath, index_key_t const& key, _Exif const& exif) {
+        auto record = make_record(filepath, key);
+        record.thumbnail_offset_ = exif.thumbnail_location.offset;
+        record.thumbnail_size_ = exif.thumbnail_location.size;
+        
+        std::vector<index_ifd_record_t> ifd_records;
+        for (auto const& ifd: exif.ifds) {
+            ifd_records.push_back(append_ifd(index_ifd_kind_t::ifd, ifd));
+        }
+        // empty ones are omitted
+        if (!exif.exif.empty()) {
+            ifd_records.push_back(append_ifd(index_ifd_kind_t::exif, exif.exif));
+        }
+        if (!exif.gps.empty()) {
+            ifd_records.push_back(append_ifd(index_ifd_kind_t::gps, exif.gps));
+        }
+        if (!exif.interop.empty()) {
+            ifd_records.push_back(append_ifd(index_ifd_kind_t::interop, exif.interop));
+        }
+        for (auto const& ifd: exif.sub_ifds) {
+            ifd_records.push_back(append_ifd(index_ifd_kind_t::sub_ifd, ifd));
+        }
+        if (!exif.maker_note.empty()) {
+            ifd_records.push_back(append_ifd(index_ifd_kind_t::maker_note, exif.maker_note));
+        }
+        record.ifds_offset_ = append(ifd_records.data(), ifd_records.size() * sizeof(index_ifd_record_t));
+        record.number_of_ifds_ = static_cast<uint32_t>(ifd_records.size());
+        records_.push_back(record);
+    }
+    
+    index_ifd_record_t index_builder_t::append_ifd(index_ifd_kind_t const kind, ifd_t const& ifd) {
+        std::vector<index_entry_t> entries;
+        entries.reserve(ifd.size());
+        for (auto const& tag: ifd) {
+            auto const& value = tag.second;
+            auto const offset = append(value.data().data(), value.data().size());
+            entries.push_back({tag.first, ifd_tag_type_info(value.type()).code, static_cast<uint32_t>(value.value_count()), offset});
+        }
+        return {static_cast<uint32_t>(kind), static_cast<uint32_t>(entries.size()), append(entries.data(), entries.size() * sizeof(index_entry_t))};
+    }
+    
+    index_ifd_record_t index_builder_t::append_ifd(index_ifd_kind_t const kind, index_ifd_view_t const& ifd) {
+        std::vector<index_entry_t> entries(ifd.begin(), ifd.end());
+        for (auto& entry: entries) {
+            auto const value = ifd.value(entry);
+            entry.offset_ = append(value.data(), value.size());
+        }
+        return {static_cast<uint32_t>(kind), static_cast<uint32_t>(entries.size()), append(entries.data(), entries.size() * sizeof(index_entry_t))};
+    }
+    
+    // Returns false if the file is not a regular file (e.g. not found)
+    bool stat_index_key(char const* filepath, index_key_t& key) {
+#if BB_MAPPED_FILE_AVAILABLE
+        struct stat st;
+        if (::stat(filepath, &st) != 0 || !S_ISREG(st.st_mode)) {
+            return false;
+        }
+#if defined(__APPLE__)
+        auto const& mtime = st.st_mtimespec;
+#else
+        auto const& mtime = st.st_mtim;
+#endif
+        key = {static_cast<uint64_t>(st.st_size), static_cast<int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec, static_cast<uint64_t>(st.st_ino)};
+        return true;
+#else
+        (void)filepath;
+        (void)key;
+        return false;
+#endif
+    }
+    
+    index_stats_t update_index(std::string const& index_filepath, std::vector<std::string> const& filepaths) {
+        return update_index(index_filepath, filepaths, index_options_t());
+    }
+    
+    // Makes the index of filepaths, other files in the current index are dropped
+    // Files are looked up by the same path as filepaths, e.g. "photos/a.jpg" and "./photos/a.jpg" are different
+    index_stats_t update_index(std::string const& index_filepath, std::vector<std::string> const& filepaths, index_options_t const& options) {
+#if BB_MAPPED_FILE_AVAILABLE
+        auto const lock_filepath = index_filepath + ".lock";
+        int lock_fd = ::open(lock_filepath.c_str(), O_RDWR | O_CREAT, 0644);
+        if (lock_fd < 0 || ::flock(lock_fd, LOCK_EX) != 0) {
+            if (lock_fd >= 0) {
+                ::close(lock_fd);
+            }
+            throw std::runtime_error(bb_trace_message("Unable to lock the file: %s", lock_filepath.c_str()));
+        }
+        auto unlock = bb::make_scope_exit([lock_fd]() {
+            ::close(lock_fd);
+        });
+#endif
+
+        // missing or broken one is rebuilt
+        exif_index_t current;
+        current.open(index_filepath.c_str());
+        
+        auto read_options = options.read_options;
+        read_options.copies_thumbnail = false;
+        index_builder_t builder;
+        index_stats_t stats;
+        std::mutex mutex;
+        std::vector<std::string> sorted_filepaths(filepaths);
+        std::sort(sorted_filepaths.begin(), sorted_filepaths.end());
+        sorted_filepaths.erase(std::unique(sorted_filepaths.begin(), sorted_filepaths.end()), sorted_filepaths.end());
+        {
+            // destruction waits for all submitted tasks
+            bb::thread_pool pool(options.number_of_threads);
+            for (auto const& filepath: sorted_filepaths) {
+                // before parsing, so that a modification while parsing is detected by the next update
+                index_key_t key;
+                if (!stat_index_key(filepath.c_str(), key)) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++stats.number_of_failed;
+                    continue;
+                }
+                auto const record = current.find(filepath);
+                if (record && record->key() == key) {
+                    // a broken record is parsed again
+                    auto exif = current.exif(*record);
+                    if (exif || !record->has_exif()) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (exif) {
+                            builder.add(filepath, key, *exif);
+                        }
+                        else {
+                            builder.add(filepath, key, exif.error());
+                        }
+                        ++stats.number_of_reused;
+                        continue;
+                    }
+                }
+                pool.submit([&builder, &stats, &mutex, &filepath, key, &options, &read_options]() {
+                    try {
+                        auto exif = try_read_exif(filepath, options.access, read_options);
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (exif) {
+                            builder.add(filepath, key, *exif);
+                        }
+                        else {
+                            builder.add(filepath, key, exif.error());
+                        }
+                        ++stats.number_of_parsed;
+                    }
+                    catch (...) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        ++stats.number_of_failed;
+                    }
+                });
+            }
+        }
+        builder.write(index_filepath);
+        return stats;
+    }
+    
+    ifd_t make_ifd(index_ifd_view_t const& view) {
+        ifd_t ifd;
+        ifd.reserve(view.size());
+        for (auto const& entry: view) {
+            auto const value = view.value(entry);
+            data_t tag_data(reinterpret_cast<char const*>(value.data()), reinterpret_cast<char const*>(value.data()) + value.size());
+            ifd.emplace_hint(ifd.end(), entry.id(), ifd_value_t{entry.type(), entry.count(), std::move(tag_data)});
+        }
+        return ifd;
+    }
+    
+    // The thumbnail is empty, see read_thumbnail()
+    exif_t make_exif(index_exif_t const& view) {
+        std::vector<ifd_t> ifds;
+        ifds.reserve(view.ifds.size());
+        for (auto const& ifd: view.ifds) {
+            ifds.push_back(make_ifd(ifd));
+        }
+        std::vector<ifd_t> sub_ifds;
+        sub_ifds.reserve(view.sub_ifds.size());
+        for (auto const& ifd: view.sub_ifds) {
+            sub_ifds.push_back(make_ifd(ifd));
+        }
+        return {std::move(ifds), make_ifd(view.exif), make_ifd(view.gps), data_t(), view.thumbnail_location, make_ifd(view.interop), std::move(sub_ifds), make_ifd(view.maker_note)};
+    }
+    
+    // The returned value refers to the index if it is not scalar
+    template <typename _Tag>
+    bb::optional<tag_value_t<_Tag>> get(index_ifd_view_t const& ifd) {
+        auto const entry = ifd.find(_Tag::id);
+        if (!entry) {
+            return bb::nullopt;
+        }
+        return decode_tag<_Tag>(ifd.value(*entry));
+    }
+    
+    template <typename _Tag, ifd_kind_t _Ifd>
+    bb::optional<tag_value_t<_Tag>> get(index_exif_t const& exif) {
+        auto const ifd = tag_ifd<_Ifd>::of(exif);
+        if (!ifd) {
+            return bb::nullopt;
+        }
+        return get<_Tag>(*ifd);
+    }
+}
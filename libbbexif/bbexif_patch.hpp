@@ -0,0 +1,251 @@
+//
+//  bbexif_patch.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ Patches tag values in place, without rewriting the file:
+ - a new value must have the same type and no more values than the recorded one, so it fits in the existing slot
+ - only the IFD entry and the value are written (with pwrite() or through mmap), in the byte order of the file
+ - all patches are checked before writing any of them
+``` */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bbexif.hpp"
+#include "bbexif_query.hpp"
+
+namespace bbexif {
+    // New value of the tag, in the native byte order as ifd_value_t of exif_t
+    struct tag_patch_t {
+        ifd_kind_t ifd;
+        ifd_tag_id_t id;
+        ifd_value_t value;
+    };
+    
+    // Bytes to write at offset, in the byte order of the file
+    struct patch_write_t {
+        uint64_t offset;
+        std::vector<char> data;
+    };
+    
+    enum class patch_method_t {
+        pwrite,
+        mmap, // maps only the pages to write
+    };
+    
+    void patch_exif(std::string const& filepath, std::vector<tag_patch_t> const& patches);
+    void patch_exif(std::string const& filepath, std::vector<tag_patch_t> const& patches, patch_method_t const method);
+    void patch_exif_in_jpeg(char* ptr, size_t const size, std::vector<tag_patch_t> const& patches);
+    std::vector<patch_write_t> plan_patches_in_app1_segment(char const* ptr, size_t const size, std::vector<tag_patch_t> const& patches);
+    template <bb::byte_order_t _ByteOrder>
+    std::vector<patch_write_t> plan_patches_in_tiff(bb::memory_reader& mr, std::vector<tag_patch_t> const& patches);
+    
+    void patch_exif(std::string const& filepath, std::vector<tag_patch_t> const& patches) {
+        patch_exif(filepath, patches, patch_method_t::pwrite);
+    }
+    
+    // Reads only the beginning of the file to locate the tags, and writes only the patched bytes
+    void patch_exif(std::string const& filepath, std::vector<tag_patch_t> const& patches, patch_method_t const method) {
+        // offsets are from the beginning of the file
+        auto const writes = with_app1_segment(filepath, file_access_t::prefix, read_options_t(), [&patches](char const* ptr, size_t const size, uint64_t const offset) {
+            auto writes = plan_patches_in_app1_segment(ptr, size, patches);
+            for (auto& write: writes) {
+                write.offset += offset;
+            }
+            return writes;
+        });
+        if (writes.empty()) {
+            return;
+        }
+
+#if BB_MAPPED_FILE_AVAILABLE
+        int fd = ::open(filepath.c_str(), O_RDWR);
+        if (fd < 0) {
+            throw std::runtime_error(bb_trace_message("Unable to open the file: %s", filepath.c_str()));
+        }
+        auto close_file = bb::make_scope_exit([fd]() {
+            ::close(fd);
+        });
+        
+        if (method == patch_method_t::mmap) {
+            uint64_t begin = writes.front().offset;
+            uint64_t end = 0;
+            for (auto const& write: writes) {
+                begin = std::min(begin, write.offset);
+                end = std::max(end, write.offset + write.data.size());
+            }
+            // The mapping must start at a page boundary
+            begin -= begin % static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+            auto const size = static_cast<size_t>(end - begin);
+            void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(begin));
+            if (ptr == MAP_FAILED) {
+                throw std::runtime_error(bb_trace_message("Unable to map the file: %s", filepath.c_str()));
+            }
+            auto unmap = bb::make_scope_exit([ptr, size]() {
+                ::munmap(ptr, size);
+            });
+            for (auto const& write: writes) {
+                std::memcpy(static_cast<char*>(ptr) + (write.offset - begin), write.data.data(), write.data.size());
+            }
+            if (::msync(ptr, size, MS_SYNC) != 0) {
+                throw std::runtime_error(bb_trace_message("Unable to write the file: %s", filepath.c_str()));
+            }
+            return;
+        }
+        
+        for (auto const& write: writes) {
+            size_t done = 0;
+            while (done < write.data.size()) {
+                auto const n = ::pwrite(fd, write.data.data() + done, write.data.size() - done, static_cast<off_t>(write.offset + done));
+                if (n <= 0) {
+                    throw std::runtime_error(bb_trace_message("Unable to write the file: %s", filepath.c_str()));
+                }
+                done += static_cast<size_t>(n);
+            }
+        }
+#else
+        (void)method;
+        std::fstream fs;
+        fs.open(filepath, std::ios::in | std::ios::out | std::ios::binary);
+        if (!fs.is_open()) {
+            throw std::runtime_error(bb_trace_message("Unable to open the file: %s", filepath.c_str()));
+        }
+        for (auto const& write: writes) {
+            fs.seekp(static_cast<std::streamoff>(write.offset));
+            fs.write(write.data.data(), static_cast<std::streamsize>(write.data.size()));
+        }
+        if (!fs.flush()) {
+            throw std::runtime_error(bb_trace_message("Unable to write the file: %s", filepath.c_str()));
+        }
+#endif
+    }
+    
+    // ptr: JPEG data to patch
+    void patch_exif_in_jpeg(char* ptr, size_t const size, std::vector<tag_patch_t> const& patches) {
+        auto const app1_segment = find_app1_segment(ptr, size);
+        auto const app1_offset = static_cast<size_t>(app1_segment.first - ptr);
+        for (auto const& write: plan_patches_in_app1_segment(app1_segment.first, app1_segment.second, patches)) {
+            std::memcpy(ptr + app1_offset + write.offset, write.data.data(), write.data.size());
+        }
+    }
+    
+    // Returns writes to apply the patches, offsets are from ptr
+    // Throws if any of the patches does not fit, then nothing should be written
+    std::vector<patch_write_t> plan_patches_in_app1_segment(char const* ptr, size_t const size, std::vector<tag_patch_t> const& patches) {
+        auto mr = bb::memory_reader(reinterpret_cast<uint8_t const*>(ptr), size);
+        auto const bo = read_exif_header(mr);
+        auto writes = bo == bb::byte_order_t::big_endian ? plan_patches_in_tiff<bb::byte_order_t::big_endian>(mr, patches) : plan_patches_in_tiff<bb::byte_order_t::little_endian>(mr, patches);
+        for (auto& write: writes) {
+            write.offset += exif_header_size;
+        }
+        return writes;
+    }
+    
+    // mr: at the version field, next to the byte order of the TIFF header
+    // Offsets of the returned writes are from the TIFF header
+    template <bb::byte_order_t _ByteOrder>
+    std::vector<patch_write_t> plan_patches_in_tiff(bb::memory_reader& mr, std::vector<tag_patch_t> const& patches) {
+        if (bb::read<uint16_t, _ByteOrder>(mr) != 0x002A) {
+            throw std::runtime_error(bb_trace_message("Unsupported Exif version"));
+        }
+        
+        // Returns the offset of the last entry of id in the IFD, 0 if not found
+        auto find_entry = [&mr](uint32_t const ifd_offset, ifd_tag_id_t const id) {
+            size_t entry_offset = 0;
+            if (ifd_offset == 0 || mr.available(ifd_offset) < 2) {
+                return entry_offset;
+            }
+            auto const number_of_ifd_tags = bb::peek<uint16_t, _ByteOrder>(mr, ifd_offset);
+            if (mr.available(ifd_offset + 2) < number_of_ifd_tags * sizeof(ifd_tag_t) + 4) {
+                return entry_offset;
+            }
+            for (size_t ti = 0; ti < number_of_ifd_tags; ++ti) {
+                auto const offset = ifd_offset + 2 + ti * sizeof(ifd_tag_t);
+                if (bb::peek<uint16_t, _ByteOrder>(mr, offset) == id) {
+                    entry_offset = offset;
+                }
+            }
+            return entry_offset;
+        };
+        
+        // offsets to IFDs, indexed by ifd_kind_t
+        uint32_t ifd_offsets[4] = {};
+        auto const ifd0_offset = bb::read<uint32_t, _ByteOrder>(mr);
+        if (ifd0_offset >= mr.cursor() && mr.available(ifd0_offset) >= 2) {
+            ifd_offsets[static_cast<size_t>(ifd_kind_t::ifd0)] = ifd0_offset;
+            auto const next_ifd_offset_offset = ifd0_offset + 2 + bb::peek<uint16_t, _ByteOrder>(mr, ifd0_offset) * sizeof(ifd_tag_t);
+            if (mr.available(next_ifd_offset_offset) >= 4) {
+                ifd_offsets[static_cast<size_t>(ifd_kind_t::ifd1)] = bb::peek<uint32_t, _ByteOrder>(mr, next_ifd_offset_offset);
+            }
+            static ifd_tag_id_t const exif_ifd_tag_id = 0x8769;
+            static ifd_tag_id_t const gps_ifd_tag_id = 0x8825;
+            for (auto const kind: {ifd_kind_t::exif, ifd_kind_t::gps}) {
+                auto const entry_offset = find_entry(ifd0_offset, kind == ifd_kind_t::exif ? exif_ifd_tag_id : gps_ifd_tag_id);
+                // LONG
+                if (entry_offset != 0 && bb::peek<uint16_t, _ByteOrder>(mr, entry_offset + 2) == 4) {
+                    ifd_offsets[static_cast<size_t>(kind)] = bb::peek<uint32_t, _ByteOrder>(mr, entry_offset + 8);
+                }
+            }
+        }
+        
+        std::vector<patch_write_t> writes;
+        for (auto const& patch: patches) {
+            auto const entry_offset = find_entry(ifd_offsets[static_cast<size_t>(patch.ifd)], patch.id);
+            if (entry_offset == 0) {
+                throw std::runtime_error(bb_trace_message("Tag not found: 0x%04X", patch.id));
+            }
+            auto entry_mr = bb::memory_reader(mr.ptr(), mr.size());
+            entry_mr.move_to(entry_offset);
+            ifd_entry_t entry;
+            if (!bb::read_ifd_entry<_ByteOrder>(entry_mr, entry)) {
+                throw std::runtime_error(bb_trace_message("Unable to read the tag: 0x%04X", patch.id));
+            }
+            
+            auto const& value = patch.value;
+            auto const type_size = ifd_tag_type_size(entry.type());
+            if (value.type() != entry.type() || value.value_count() == 0 || value.value_count() > entry.count() || value.data().size() != value.value_count() * type_size) {
+                throw std::runtime_error(bb_trace_message("The value does not fit in the tag: 0x%04X", patch.id));
+            }
+            
+            std::vector<char> data(value.data().begin(), value.data().end());
+            if (_ByteOrder != bb::native_byte_order_constant) {
+                // rational and srational are pairs of long
+                auto const word_size = type_size == 8 ? 4 : type_size;
+                for (size_t i = 0; word_size > 1 && i < data.size(); i += word_size) {
+                    std::reverse(data.begin() + i, data.begin() + i + word_size);
+                }
+            }
+            if (data.size() <= 4) {
+                // in the entry, even if the recorded value(s) are out of it
+                data.resize(4);
+                writes.push_back({entry_offset + 8, std::move(data)});
+            }
+            else {
+                // clears the rest of the slot
+                data.resize(entry.count() * type_size);
+                writes.push_back({entry.offset(), std::move(data)});
+            }
+            if (value.value_count() != entry.count()) {
+                auto count = static_cast<uint32_t>(value.value_count());
+                if (_ByteOrder != bb::native_byte_order_constant) {
+                    count = bb::byte_swap(count);
+                }
+                std::vector<char> count_data(sizeof(count));
+                std::memcpy(count_data.data(), &count, sizeof(count));
+                writes.push_back({entry_offset + 4, std::move(count_data)});
+            }
+        }
+        return writes;
+    }
+}
@@ -0,0 +1,202 @@
+//
+//  bbexif_query.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ Reads only the specified tags:
+ - IFDs without queried tags are not followed (e.g. 1st IFD, GPS IFD)
+ - entries of other tags are skipped without decoding
+ - stops as soon as all queried tags are found
+``` */
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bbexif.hpp"
+
+namespace bbexif {
+    enum class ifd_kind_t {
+        ifd0, // 0th IFD, primary image
+        ifd1, // 1st IFD, thumbnail
+        exif,
+        gps,
+    };
+    
+    struct tag_query_t {
+        ifd_kind_t ifd;
+        ifd_tag_id_t id;
+    };
+    
+    exif_t query_exif(std::string const& filepath, std::vector<tag_query_t> const& queries);
+    exif_t query_exif(std::string const& filepath, std::vector<tag_query_t> const& queries, file_access_t const access);
+    exif_view_t query_exif_view_from_jpeg(char const* ptr, size_t const size, std::vector<tag_query_t> const& queries);
+    exif_view_t query_exif_view_from_app1_segment(char const* ptr, size_t const size, std::vector<tag_query_t> const& queries);
+    template <bb::byte_order_t _ByteOrder>
+    exif_view_t query_exif_view_from_tiff(bb::memory_reader& mr, std::vector<tag_query_t> const& queries);
+    
+    // The returned exif_t has only found tags, and has no thumbnail
+    exif_t query_exif(std::string const& filepath, std::vector<tag_query_t> const& queries) {
+        return query_exif(filepath, queries, file_access_t::mmap);
+    }
+    
+    exif_t query_exif(std::string const& filepath, std::vector<tag_query_t> const& queries, file_access_t const access) {
+        return with_app1_segment(filepath, access, read_options_t(), [&queries](char const* ptr, size_t const size, uint64_t) {
+            return make_exif(query_exif_view_from_app1_segment(ptr, size, queries));
+        });
+    }
+    
+    // The returned view refers to [ptr, ptr + size)
+    exif_view_t query_exif_view_from_jpeg(char const* ptr, size_t const size, std::vector<tag_query_t> const& queries) {
+        auto app1_segment = find_app1_segment(ptr, size);
+        return query_exif_view_from_app1_segment(app1_segment.first, app1_segment.second, queries);
+    }
+    
+    // The returned view refers to [ptr, ptr + size)
+    exif_view_t query_exif_view_from_app1_segment(char const* ptr, size_t const size, std::vector<tag_query_t> const& queries) {
+        auto mr = bb::memory_reader(reinterpret_cast<uint8_t const*>(ptr), size);
+        auto const bo = read_exif_header(mr);
+        if (bo == bb::byte_order_t::big_endian) {
+            return query_exif_view_from_tiff<bb::byte_order_t::big_endian>(mr, queries);
+        }
+        return query_exif_view_from_tiff<bb::byte_order_t::little_endian>(mr, queries);
+    }
+    
+    // mr: at the version field, next to the byte order of the TIFF header
+    template <bb::byte_order_t _ByteOrder>
+    exif_view_t query_exif_view_from_tiff(bb::memory_reader& mr, std::vector<tag_query_t> const& queries) {
+        if (bb::read<uint16_t, _ByteOrder>(mr) != 0x002A) {
+            throw std::runtime_error(bb_trace_message("Unsupported Exif version"));
+        }
+        
+        exif_view_t view{};
+        view.byte_order = _ByteOrder;
+        std::vector<bool> is_found(queries.size(), false);
+        // the number of not found queries for each ifd_kind_t
+        size_t remaining[4] = {};
+        for (auto const& query: queries) {
+            ++remaining[static_cast<size_t>(query.ifd)];
+        }
+        
+        // pointer tags to sub IFDs
+        struct pointer_t {
+            ifd_tag_id_t id;
+            bool is_wanted;
+            uint32_t offset;
+        };
+        
+        // Picks up queried entries of the IFD at offset, and offsets of wanted pointers
+        // Returns the offset to the next IFD
+        auto scan_ifd = [&mr, &queries, &is_found, &remaining](ifd_kind_t const kind, uint32_t const offset, ifd_view_t& ifd, pointer_t* pointers, size_t const number_of_pointers) {
+            ifd.ptr_ = mr.ptr();
+            ifd.size_ = mr.size();
+            ifd.byte_order_ = _ByteOrder;
+            
+            if (mr.available(offset) < 2) {
+                throw std::runtime_error(bb_trace_message("Unable to read Exif"));
+            }
+            auto ifd_mr = bb::memory_reader(mr.ptr(), mr.size());
+            ifd_mr.move_to(offset);
+            auto number_of_ifd_tags = bb::read<uint16_t, _ByteOrder>(ifd_mr);
+            if (ifd_mr.available() < number_of_ifd_tags * sizeof(ifd_tag_t) + 4) {
+                throw std::runtime_error(bb_trace_message("Unable to read Exif"));
+            }
+            auto const next_ifd_offset = bb::peek<uint32_t, _ByteOrder>(ifd_mr, ifd_mr.cursor() + number_of_ifd_tags * sizeof(ifd_tag_t));
+            
+            auto& kind_remaining = remaining[static_cast<size_t>(kind)];
+            size_t pending_pointers = 0;
+            for (size_t pi = 0; pi < number_of_pointers; ++pi) {
+                pending_pointers += pointers[pi].is_wanted ? 1 : 0;
+            }
+            for (auto ti = 0; ti < number_of_ifd_tags && (kind_remaining > 0 || pending_pointers > 0); ++ti) {
+                auto const id = bb::peek<uint16_t, _ByteOrder>(ifd_mr, ifd_mr.cursor());
+                bool is_queried = false;
+                for (size_t qi = 0; qi < queries.size(); ++qi) {
+                    is_queried |= !is_found[qi] && queries[qi].ifd == kind && queries[qi].id == id;
+                }
+                pointer_t* pointer = nullptr;
+                for (size_t pi = 0; pi < number_of_pointers; ++pi) {
+                    if (pointers[pi].is_wanted && pointers[pi].id == id) {
+                        pointer = &pointers[pi];
+                    }
+                }
+                if (!is_queried && !pointer) {
+                    ifd_mr.move(sizeof(ifd_tag_t));
+                    continue;
+                }
+                
+                ifd_entry_t entry;
+                if (!bb::read_ifd_entry<_ByteOrder>(ifd_mr, entry)) {
+                    continue;
+                }
+                if (is_queried) {
+                    for (size_t qi = 0; qi < queries.size(); ++qi) {
+                        if (!is_found[qi] && queries[qi].ifd == kind && queries[qi].id == id) {
+                            is_found[qi] = true;
+                            --kind_remaining;
+                        }
+                    }
+                    ifd.entries_.push_back(entry);
+                }
+                if (pointer) {
+                    if (entry.type() == ifd_tag_type_t::long_ && entry.count() >= 1) {
+                        pointer->offset = ifd.value(entry).value<uint32_t>();
+                    }
+                    pointer->is_wanted = false;
+                    --pending_pointers;
+                }
+            }
+            std::sort(ifd.entries_.begin(), ifd.entries_.end(), [](ifd_entry_t const& lhs, ifd_entry_t const& rhs) {
+                return lhs.id() < rhs.id();
+            });
+            return next_ifd_offset;
+        };
+        
+        auto const ifd0_offset = bb::read<uint32_t, _ByteOrder>(mr);
+        if (ifd0_offset == 0 || queries.empty()) {
+            return view;
+        }
+        
+        // Offsets may point backward, an IFD already scanned (e.g. a loop) is skipped
+        // Returns false if the IFD at offset is already scanned, otherwise records it
+        uint32_t visited_offsets[4] = {};
+        size_t number_of_visited = 0;
+        auto visit = [&visited_offsets, &number_of_visited](uint32_t const offset) {
+            if (std::find(visited_offsets, visited_offsets + number_of_visited, offset) != visited_offsets + number_of_visited) {
+                return false;
+            }
+            visited_offsets[number_of_visited++] = offset;
+            return true;
+        };
+        visit(ifd0_offset);
+        
+        static ifd_tag_id_t const exif_ifd_tag_id = 0x8769;
+        static ifd_tag_id_t const gps_ifd_tag_id = 0x8825;
+        pointer_t pointers[] = {
+            { exif_ifd_tag_id, remaining[static_cast<size_t>(ifd_kind_t::exif)] > 0, 0 },
+            { gps_ifd_tag_id, remaining[static_cast<size_t>(ifd_kind_t::gps)] > 0, 0 },
+        };
+        view.ifds.emplace_back();
+        auto const ifd1_offset = scan_ifd(ifd_kind_t::ifd0, ifd0_offset, view.ifds[0], pointers, 2);
+        
+        if (remaining[static_cast<size_t>(ifd_kind_t::ifd1)] > 0 && ifd1_offset != 0 && visit(ifd1_offset)) {
+            view.ifds.emplace_back();
+            scan_ifd(ifd_kind_t::ifd1, ifd1_offset, view.ifds[1], nullptr, 0);
+        }
+        if (remaining[static_cast<size_t>(ifd_kind_t::exif)] > 0 && pointers[0].offset != 0 && visit(pointers[0].offset)) {
+            scan_ifd(ifd_kind_t::exif, pointers[0].offset, view.exif, nullptr, 0);
+        }
+        if (remaining[static_cast<size_t>(ifd_kind_t::gps)] > 0 && pointers[1].offset != 0 && visit(pointers[1].offset)) {
+            scan_ifd(ifd_kind_t::gps, pointers[1].offset, view.gps, nullptr, 0);
+        }
+        return view;
+    }
+}
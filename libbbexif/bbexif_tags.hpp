@@ -0,0 +1,399 @@
+//
+//  bbexif_tags.hpp
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+#pragma once
+
+// [C++14]
+
+/* ```Markdown
+ Registry of the standard tags (CIPA DC-008), to get typed values without raw ids nor casts:
+ - each tag is a type with its IFD, id, type and count, e.g. `get<tag::Orientation>(exif)` returns bb::optional<uint16_t>
+ - the IFD and the decoding are resolved at compile time, and nothing is allocated
+ - works with both of exif_t and exif_view_t (or an ifd_t / ifd_view_t)
+ - empty if the tag is not found or it is recorded with another type or count
+ 
+ Types of values:
+ | Tag                                       | Value                                    |
+ |-------------------------------------------|------------------------------------------|
+ | ASCII                                     | bb::string_view, until the first NUL     |
+ | UNDEFINED, count is not 1                 | bb::string_view, raw bytes               |
+ | count is 1                                | the value, e.g. uint16_t, ifd_tag_type_rational_t |
+ | count is fixed, e.g. GPSLatitude          | std::array                               |
+ | count is not fixed, e.g. StripOffsets     | tag_values_t, decodes on demand          |
+ 
+ LONG tags accept SHORT values, because some of them are "SHORT or LONG" (e.g. ImageWidth).
+ Tags of the 0th IFD can be read from the 1st IFD, e.g. `get<tag::XResolution, ifd_kind_t::ifd1>(exif)`
+``` */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "bbexif.hpp"
+#include "bbexif_query.hpp"
+#include "bb/optional.hpp"
+#include "bb/string_view.hpp"
+
+namespace bbexif {
+    // _Count: 0 if the number of values is not fixed
+    template <ifd_kind_t _Ifd, ifd_tag_id_t _Id, ifd_tag_type_t _Type, size_t _Count>
+    struct tag_t {
+        static constexpr ifd_kind_t ifd = _Ifd;
+        static constexpr ifd_tag_id_t id = _Id;
+        static constexpr ifd_tag_type_t type = _Type;
+        static constexpr size_t count = _Count;
+    };
+    
+    template <ifd_kind_t _Ifd, ifd_tag_id_t _Id, ifd_tag_type_t _Type, size_t _Count>
+    constexpr ifd_kind_t tag_t<_Ifd, _Id, _Type, _Count>::ifd;
+    template <ifd_kind_t _Ifd, ifd_tag_id_t _Id, ifd_tag_type_t _Type, size_t _Count>
+    constexpr ifd_tag_id_t tag_t<_Ifd, _Id, _Type, _Count>::id;
+    template <ifd_kind_t _Ifd, ifd_tag_id_t _Id, ifd_tag_type_t _Type, size_t _Count>
+    constexpr ifd_tag_type_t tag_t<_Ifd, _Id, _Type, _Count>::type;
+    template <ifd_kind_t _Ifd, ifd_tag_id_t _Id, ifd_tag_type_t _Type, size_t _Count>
+    constexpr size_t tag_t<_Ifd, _Id, _Type, _Count>::count;
+    
+    namespace tag {
+        // 0th IFD (TIFF)
+        using ImageWidth = tag_t<ifd_kind_t::ifd0, 0x0100, ifd_tag_type_t::long_, 1>;
+        using ImageLength = tag_t<ifd_kind_t::ifd0, 0x0101, ifd_tag_type_t::long_, 1>;
+        using BitsPerSample = tag_t<ifd_kind_t::ifd0, 0x0102, ifd_tag_type_t::short_, 3>;
+        using Compression = tag_t<ifd_kind_t::ifd0, 0x0103, ifd_tag_type_t::short_, 1>;
+        using PhotometricInterpretation = tag_t<ifd_kind_t::ifd0, 0x0106, ifd_tag_type_t::short_, 1>;
+        using ImageDescription = tag_t<ifd_kind_t::ifd0, 0x010E, ifd_tag_type_t::ascii, 0>;
+        using Make = tag_t<ifd_kind_t::ifd0, 0x010F, ifd_tag_type_t::ascii, 0>;
+        using Model = tag_t<ifd_kind_t::ifd0, 0x0110, ifd_tag_type_t::ascii, 0>;
+        using StripOffsets = tag_t<ifd_kind_t::ifd0, 0x0111, ifd_tag_type_t::long_, 0>;
+        using Orientation = tag_t<ifd_kind_t::ifd0, 0x0112, ifd_tag_type_t::short_, 1>;
+        using SamplesPerPixel = tag_t<ifd_kind_t::ifd0, 0x0115, ifd_tag_type_t::short_, 1>;
+        using RowsPerStrip = tag_t<ifd_kind_t::ifd0, 0x0116, ifd_tag_type_t::long_, 1>;
+        using StripByteCounts = tag_t<ifd_kind_t::ifd0, 0x0117, ifd_tag_type_t::long_, 0>;
+        using XResolution = tag_t<ifd_kind_t::ifd0, 0x011A, ifd_tag_type_t::rational, 1>;
+        using YResolution = tag_t<ifd_kind_t::ifd0, 0x011B, ifd_tag_type_t::rational, 1>;
+        using PlanarConfiguration = tag_t<ifd_kind_t::ifd0, 0x011C, ifd_tag_type_t::short_, 1>;
+        using ResolutionUnit = tag_t<ifd_kind_t::ifd0, 0x0128, ifd_tag_type_t::short_, 1>;
+        using TransferFunction = tag_t<ifd_kind_t::ifd0, 0x012D, ifd_tag_type_t::short_, 3 * 256>;
+        using Software = tag_t<ifd_kind_t::ifd0, 0x0131, ifd_tag_type_t::ascii, 0>;
+        using DateTime = tag_t<ifd_kind_t::ifd0, 0x0132, ifd_tag_type_t::ascii, 20>;
+        using Artist = tag_t<ifd_kind_t::ifd0, 0x013B, ifd_tag_type_t::ascii, 0>;
+        using WhitePoint = tag_t<ifd_kind_t::ifd0, 0x013E, ifd_tag_type_t::rational, 2>;
+        using PrimaryChromaticities = tag_t<ifd_kind_t::ifd0, 0x013F, ifd_tag_type_t::rational, 6>;
+        using YCbCrCoefficients = tag_t<ifd_kind_t::ifd0, 0x0211, ifd_tag_type_t::rational, 3>;
+        using YCbCrSubSampling = tag_t<ifd_kind_t::ifd0, 0x0212, ifd_tag_type_t::short_, 2>;
+        using YCbCrPositioning = tag_t<ifd_kind_t::ifd0, 0x0213, ifd_tag_type_t::short_, 1>;
+        using ReferenceBlackWhite = tag_t<ifd_kind_t::ifd0, 0x0214, ifd_tag_type_t::rational, 6>;
+        using Copyright = tag_t<ifd_kind_t::ifd0, 0x8298, ifd_tag_type_t::ascii, 0>;
+        
+        // 1st IFD
+        using JPEGInterchangeFormat = tag_t<ifd_kind_t::ifd1, 0x0201, ifd_tag_type_t::long_, 1>;
+        using JPEGInterchangeFormatLength = tag_t<ifd_kind_t::ifd1, 0x0202, ifd_tag_type_t::long_, 1>;
+        
+        // Exif IFD
+        using ExposureTime = tag_t<ifd_kind_t::exif, 0x829A, ifd_tag_type_t::rational, 1>;
+        using FNumber = tag_t<ifd_kind_t::exif, 0x829D, ifd_tag_type_t::rational, 1>;
+        using ExposureProgram = tag_t<ifd_kind_t::exif, 0x8822, ifd_tag_type_t::short_, 1>;
+        using SpectralSensitivity = tag_t<ifd_kind_t::exif, 0x8824, ifd_tag_type_t::ascii, 0>;
+        using PhotographicSensitivity = tag_t<ifd_kind_t::exif, 0x8827, ifd_tag_type_t::short_, 0>;
+        using OECF = tag_t<ifd_kind_t::exif, 0x8828, ifd_tag_type_t::undefined, 0>;
+        using SensitivityType = tag_t<ifd_kind_t::exif, 0x8830, ifd_tag_type_t::short_, 1>;
+        using ExifVersion = tag_t<ifd_kind_t::exif, 0x9000, ifd_tag_type_t::undefined, 4>;
+        using DateTimeOriginal = tag_t<ifd_kind_t::exif, 0x9003, ifd_tag_type_t::ascii, 20>;
+        using DateTimeDigitized = tag_t<ifd_kind_t::exif, 0x9004, ifd_tag_type_t::ascii, 20>;
+        using OffsetTime = tag_t<ifd_kind_t::exif, 0x9010, ifd_tag_type_t::ascii, 7>;
+        using OffsetTimeOriginal = tag_t<ifd_kind_t::exif, 0x9011, ifd_tag_type_t::ascii, 7>;
+        using OffsetTimeDigitized = tag_t<ifd_kind_t::exif, 0x9012, ifd_tag_type_t::ascii, 7>;
+        using ComponentsConfiguration = tag_t<ifd_kind_t::exif, 0x9101, ifd_tag_type_t::undefined, 4>;
+        using CompressedBitsPerPixel = tag_t<ifd_kind_t::exif, 0x9102, ifd_tag_type_t::rational, 1>;
+        using ShutterSpeedValue = tag_t<ifd_kind_t::exif, 0x9201, ifd_tag_type_t::srational, 1>;
+        using ApertureValue = tag_t<ifd_kind_t::exif, 0x9202, ifd_tag_type_t::rational, 1>;
+        using BrightnessValue = tag_t<ifd_kind_t::exif, 0x9203, ifd_tag_type_t::srational, 1>;
+        using ExposureBiasValue = tag_t<ifd_kind_t::exif, 0x9204, ifd_tag_type_t::srational, 1>;
+        using MaxApertureValue = tag_t<ifd_kind_t::exif, 0x9205, ifd_tag_type_t::rational, 1>;
+        using SubjectDistance = tag_t<ifd_kind_t::exif, 0x9206, ifd_tag_type_t::rational, 1>;
+        using MeteringMode = tag_t<ifd_kind_t::exif, 0x9207, ifd_tag_type_t::short_, 1>;
+        using LightSource = tag_t<ifd_kind_t::exif, 0x9208, ifd_tag_type_t::short_, 1>;
+        using Flash = tag_t<ifd_kind_t::exif, 0x9209, ifd_tag_type_t::short_, 1>;
+        using FocalLength = tag_t<ifd_kind_t::exif, 0x920A, ifd_tag_type_t::rational, 1>;
+        using SubjectArea = tag_t<ifd_kind_t::exif, 0x9214, ifd_tag_type_t::short_, 0>;
+        using MakerNote = tag_t<ifd_kind_t::exif, 0x927C, ifd_tag_type_t::undefined, 0>;
+        using UserComment = tag_t<ifd_kind_t::exif, 0x9286, ifd_tag_type_t::undefined, 0>;
+        using SubSecTime = tag_t<ifd_kind_t::exif, 0x9290, ifd_tag_type_t::ascii, 0>;
+        using SubSecTimeOriginal = tag_t<ifd_kind_t::exif, 0x9291, ifd_tag_type_t::ascii, 0>;
+        using SubSecTimeDigitized = tag_t<ifd_kind_t::exif, 0x9292, ifd_tag_type_t::ascii, 0>;
+        using FlashpixVersion = tag_t<ifd_kind_t::exif, 0xA000, ifd_tag_type_t::undefined, 4>;
+        using ColorSpace = tag_t<ifd_kind_t::exif, 0xA001, ifd_tag_type_t::short_, 1>;
+        using PixelXDimension = tag_t<ifd_kind_t::exif, 0xA002, ifd_tag_type_t::long_, 1>;
+        using PixelYDimension = tag_t<ifd_kind_t::exif, 0xA003, ifd_tag_type_t::long_, 1>;
+        using RelatedSoundFile = tag_t<ifd_kind_t::exif, 0xA004, ifd_tag_type_t::ascii, 13>;
+        using FlashEnergy = tag_t<ifd_kind_t::exif, 0xA20B, ifd_tag_type_t::rational, 1>;
+        using FocalPlaneXResolution = tag_t<ifd_kind_t::exif, 0xA20E, ifd_tag_type_t::rational, 1>;
+        using FocalPlaneYResolution = tag_t<ifd_kind_t::exif, 0xA20F, ifd_tag_type_t::rational, 1>;
+        using FocalPlaneResolutionUnit = tag_t<ifd_kind_t::exif, 0xA210, ifd_tag_type_t::short_, 1>;
+        using SubjectLocation = tag_t<ifd_kind_t::exif, 0xA214, ifd_tag_type_t::short_, 2>;
+        using ExposureIndex = tag_t<ifd_kind_t::exif, 0xA215, ifd_tag_type_t::rational, 1>;
+        using SensingMethod = tag_t<ifd_kind_t::exif, 0xA217, ifd_tag_type_t::short_, 1>;
+        using FileSource = tag_t<ifd_kind_t::exif, 0xA300, ifd_tag_type_t::undefined, 1>;
+        using SceneType = tag_t<ifd_kind_t::exif, 0xA301, ifd_tag_type_t::undefined, 1>;
+        using CFAPattern = tag_t<ifd_kind_t::exif, 0xA302, ifd_tag_type_t::undefined, 0>;
+        using CustomRendered = tag_t<ifd_kind_t::exif, 0xA401, ifd_tag_type_t::short_, 1>;
+        using ExposureMode = tag_t<ifd_kind_t::exif, 0xA402, ifd_tag_type_t::short_, 1>;
+        using WhiteBalance = tag_t<ifd_kind_t::exif, 0xA403, ifd_tag_type_t::short_, 1>;
+        using DigitalZoomRatio = tag_t<ifd_kind_t::exif, 0xA404, ifd_tag_type_t::rational, 1>;
+        using FocalLengthIn35mmFilm = tag_t<ifd_kind_t::exif, 0xA405, ifd_tag_type_t::short_, 1>;
+        using SceneCaptureType = tag_t<ifd_kind_t::exif, 0xA406, ifd_tag_type_t::short_, 1>;
+        using GainControl = tag_t<ifd_kind_t::exif, 0xA407, ifd_tag_type_t::short_, 1>;
+        using Contrast = tag_t<ifd_kind_t::exif, 0xA408, ifd_tag_type_t::short_, 1>;
+        using Saturation = tag_t<ifd_kind_t::exif, 0xA409, ifd_tag_type_t::short_, 1>;
+        using Sharpness = tag_t<ifd_kind_t::exif, 0xA40A, ifd_tag_type_t::short_, 1>;
+        using SubjectDistanceRange = tag_t<ifd_kind_t::exif, 0xA40C, ifd_tag_type_t::short_, 1>;
+        using ImageUniqueID = tag_t<ifd_kind_t::exif, 0xA420, ifd_tag_type_t::ascii, 33>;
+        using CameraOwnerName = tag_t<ifd_kind_t::exif, 0xA430, ifd_tag_type_t::ascii, 0>;
+        using BodySerialNumber = tag_t<ifd_kind_t::exif, 0xA431, ifd_tag_type_t::ascii, 0>;
+        using LensSpecification = tag_t<ifd_kind_t::exif, 0xA432, ifd_tag_type_t::rational, 4>;
+        using LensMake = tag_t<ifd_kind_t::exif, 0xA433, ifd_tag_type_t::ascii, 0>;
+        using LensModel = tag_t<ifd_kind_t::exif, 0xA434, ifd_tag_type_t::ascii, 0>;
+        using LensSerialNumber = tag_t<ifd_kind_t::exif, 0xA435, ifd_tag_type_t::ascii, 0>;
+        using Gamma = tag_t<ifd_kind_t::exif, 0xA500, ifd_tag_type_t::rational, 1>;
+        
+        // GPS IFD
+        using GPSVersionID = tag_t<ifd_kind_t::gps, 0x0000, ifd_tag_type_t::byte, 4>;
+        using GPSLatitudeRef = tag_t<ifd_kind_t::gps, 0x0001, ifd_tag_type_t::ascii, 2>;
+        using GPSLatitude = tag_t<ifd_kind_t::gps, 0x0002, ifd_tag_type_t::rational, 3>;
+        using GPSLongitudeRef = tag_t<ifd_kind_t::gps, 0x0003, ifd_tag_type_t::ascii, 2>;
+        using GPSLongitude = tag_t<ifd_kind_t::gps, 0x0004, ifd_tag_type_t::rational, 3>;
+        using GPSAltitudeRef = tag_t<ifd_kind_t::gps, 0x0005, ifd_tag_type_t::byte, 1>;
+        using GPSAltitude = tag_t<ifd_kind_t::gps, 0x0006, ifd_tag_type_t::rational, 1>;
+        using GPSTimeStamp = tag_t<ifd_kind_t::gps, 0x0007, ifd_tag_type_t::rational, 3>;
+        using GPSSatellites = tag_t<ifd_kind_t::gps, 0x0008, ifd_tag_type_t::ascii, 0>;
+        using GPSStatus = tag_t<ifd_kind_t::gps, 0x0009, ifd_tag_type_t::ascii, 2>;
+        using GPSMeasureMode = tag_t<ifd_kind_t::gps, 0x000A, ifd_tag_type_t::ascii, 2>;
+        using GPSDOP = tag_t<ifd_kind_t::gps, 0x000B, ifd_tag_type_t::rational, 1>;
+        using GPSSpeedRef = tag_t<ifd_kind_t::gps, 0x000C, ifd_tag_type_t::ascii, 2>;
+        using GPSSpeed = tag_t<ifd_kind_t::gps, 0x000D, ifd_tag_type_t::rational, 1>;
+        using GPSTrackRef = tag_t<ifd_kind_t::gps, 0x000E, ifd_tag_type_t::ascii, 2>;
+        using GPSTrack = tag_t<ifd_kind_t::gps, 0x000F, ifd_tag_type_t::rational, 1>;
+        using GPSImgDirectionRef = tag_t<ifd_kind_t::gps, 0x0010, ifd_tag_type_t::ascii, 2>;
+        using GPSImgDirection = tag_t<ifd_kind_t::gps, 0x0011, ifd_tag_type_t::rational, 1>;
+        using GPSMapDatum = tag_t<ifd_kind_t::gps, 0x0012, ifd_tag_type_t::ascii, 0>;
+        using GPSDestLatitudeRef = tag_t<ifd_kind_t::gps, 0x0013, ifd_tag_type_t::ascii, 2>;
+        using GPSDestLatitude = tag_t<ifd_kind_t::gps, 0x0014, ifd_tag_type_t::rational, 3>;
+        using GPSDestLongitudeRef = tag_t<ifd_kind_t::gps, 0x0015, ifd_tag_type_t::ascii, 2>;
+        using GPSDestLongitude = tag_t<ifd_kind_t::gps, 0x0016, ifd_tag_type_t::rational, 3>;
+        using GPSDestBearingRef = tag_t<ifd_kind_t::gps, 0x0017, ifd_tag_type_t::ascii, 2>;
+        using GPSDestBearing = tag_t<ifd_kind_t::gps, 0x0018, ifd_tag_type_t::rational, 1>;
+        using GPSDestDistanceRef = tag_t<ifd_kind_t::gps, 0x0019, ifd_tag_type_t::ascii, 2>;
+        using GPSDestDistance = tag_t<ifd_kind_t::gps, 0x001A, ifd_tag_type_t::rational, 1>;
+        using GPSProcessingMethod = tag_t<ifd_kind_t::gps, 0x001B, ifd_tag_type_t::undefined, 0>;
+        using GPSAreaInformation = tag_t<ifd_kind_t::gps, 0x001C, ifd_tag_type_t::undefined, 0>;
+        using GPSDateStamp = tag_t<ifd_kind_t::gps, 0x001D, ifd_tag_type_t::ascii, 11>;
+        using GPSDifferential = tag_t<ifd_kind_t::gps, 0x001E, ifd_tag_type_t::short_, 1>;
+        using GPSHPositioningError = tag_t<ifd_kind_t::gps, 0x001F, ifd_tag_type_t::rational, 1>;
+    }
+    
+    // C++ type of a value of ifd_tag_type_t
+    template <ifd_tag_type_t _Type>
+    struct tag_element_type;
+    template <>
+    struct tag_element_type<ifd_tag_type_t::byte> { using type = ifd_tag_type_byte_t; };
+    template <>
+    struct tag_element_type<ifd_tag_type_t::ascii> { using type = ifd_tag_type_ascii_t; };
+    template <>
+    struct tag_element_type<ifd_tag_type_t::short_> { using type = ifd_tag_type_short_t; };
+    template <>
+    struct tag_element_type<ifd_tag_type_t::long_> { using type = ifd_tag_type_long_t; };
+    template <>
+    struct tag_element_type<ifd_tag_type_t::rational> { using type = ifd_tag_type_rational_t; };
+    template <>
+    struct tag_element_type<ifd_tag_type_t::undefined> { using type = ifd_tag_type_undefined_t; };
+    template <>
+    struct tag_element_type<ifd_tag_type_t::slong> { using type = ifd_tag_type_slong_t; };
+    template <>
+    struct tag_element_type<ifd_tag_type_t::srational> { using type = ifd_tag_type_srational_t; };
+    
+    template <ifd_tag_type_t _Type>
+    inline typename tag_element_type<_Type>::type tag_element(ifd_value_view_t const& value, size_t const index) {
+        return value.value<typename tag_element_type<_Type>::type>(index);
+    }
+    
+    // LONG tags accept SHORT values
+    template <>
+    inline ifd_tag_type_long_t tag_element<ifd_tag_type_t::long_>(ifd_value_view_t const& value, size_t const index) {
+        if (value.type() == ifd_tag_type_t::short_) {
+            return value.value<ifd_tag_type_short_t>(index);
+        }
+        return value.value<ifd_tag_type_long_t>(index);
+    }
+    
+    // Values of a tag whose count is not fixed, refers to the source as ifd_value_view_t
+    template <ifd_tag_type_t _Type>
+    struct tag_values_t {
+        ifd_value_view_t value_;
+        
+        inline size_t size() const { return value_.value_count(); }
+        inline bool empty() const { return value_.value_count() == 0; }
+        inline typename tag_element_type<_Type>::type operator[](size_t const index) const { return tag_element<_Type>(value_, index); }
+    };
+    
+    enum class tag_value_kind_t {
+        scalar, // count is 1
+        array, // count is fixed
+        values, // count is not fixed
+        string, // ASCII, or UNDEFINED whose count is not 1
+    };
+    
+    template <ifd_tag_type_t _Type, size_t _Count>
+    constexpr tag_value_kind_t tag_value_kind() {
+        return _Type == ifd_tag_type_t::ascii || (_Type == ifd_tag_type_t::undefined && _Count != 1) ? tag_value_kind_t::string
+            : _Count == 1 ? tag_value_kind_t::scalar
+            : _Count == 0 ? tag_value_kind_t::values
+            : tag_value_kind_t::array;
+    }
+    
+    template <ifd_tag_type_t _Type, size_t _Count, tag_value_kind_t _Kind = tag_value_kind<_Type, _Count>()>
+    struct tag_decoder;
+    
+    template <ifd_tag_type_t _Type, size_t _Count>
+    struct tag_decoder<_Type, _Count, tag_value_kind_t::scalar> {
+        using value_type = typename tag_element_type<_Type>::type;
+        
+        static inline value_type decode(ifd_value_view_t const& value) {
+            return tag_element<_Type>(value, 0);
+        }
+    };
+    
+    template <ifd_tag_type_t _Type, size_t _Count>
+    struct tag_decoder<_Type, _Count, tag_value_kind_t::array> {
+        using value_type = std::array<typename tag_element_type<_Type>::type, _Count>;
+        
+        static inline value_type decode(ifd_value_view_t const& value) {
+            value_type values;
+            for (size_t i = 0; i < _Count; ++i) {
+                values[i] = tag_element<_Type>(value, i);
+            }
+            return values;
+        }
+    };
+    
+    template <ifd_tag_type_t _Type, size_t _Count>
+    struct tag_decoder<_Type, _Count, tag_value_kind_t::values> {
+        using value_type = tag_values_t<_Type>;
+        
+        static inline value_type decode(ifd_value_view_t const& value) {
+            return {value};
+        }
+    };
+    
+    template <ifd_tag_type_t _Type, size_t _Count>
+    struct tag_decoder<_Type, _Count, tag_value_kind_t::string> {
+        using value_type = bb::string_view;
+        
+        static inline value_type decode(ifd_value_view_t const& value) {
+            auto const ptr = reinterpret_cast<char const*>(value.data());
+            size_t size = value.size();
+            if (_Type == ifd_tag_type_t::ascii) {
+                // the count includes the terminating NUL
+                for (size_t i = 0; i < size; ++i) {
+                    if (ptr[i] == '\0') {
+                        size = i;
+                        break;
+                    }
+                }
+            }
+            return {ptr, size};
+        }
+    };
+    
+    // e.g. uint16_t for tag::Orientation
+    template <typename _Tag>
+    using tag_value_t = typename tag_decoder<_Tag::type, _Tag::count>::value_type;
+    
+    // IFD of _Ifd in exif_t or exif_view_t, nullptr if there is not
+    template <ifd_kind_t _Ifd>
+    struct tag_ifd;
+    template <>
+    struct tag_ifd<ifd_kind_t::ifd0> {
+        template <typename _Exif>
+        static inline auto of(_Exif const& exif) -> decltype(&exif.ifds[0]) { return exif.ifds.size() > 0 ? &exif.ifds[0] : nullptr; }
+    };
+    template <>
+    struct tag_ifd<ifd_kind_t::ifd1> {
+        template <typename _Exif>
+        static inline auto of(_Exif const& exif) -> decltype(&exif.ifds[1]) { return exif.ifds.size() > 1 ? &exif.ifds[1] : nullptr; }
+    };
+    template <>
+    struct tag_ifd<ifd_kind_t::exif> {
+        template <typename _Exif>
+        static inline auto of(_Exif const& exif) -> decltype(&exif.exif) { return &exif.exif; }
+    };
+    template <>
+    struct tag_ifd<ifd_kind_t::gps> {
+        template <typename _Exif>
+        static inline auto of(_Exif const& exif) -> decltype(&exif.gps) { return &exif.gps; }
+    };
+    
+    template <typename _Tag>
+    bb::optional<tag_value_t<_Tag>> decode_tag(ifd_value_view_t const& value);
+    template <typename _Tag>
+    bb::optional<tag_value_t<_Tag>> get(ifd_t const& ifd);
+    template <typename _Tag>
+    bb::optional<tag_value_t<_Tag>> get(ifd_view_t const& ifd);
+    template <typename _Tag, ifd_kind_t _Ifd = _Tag::ifd>
+    bb::optional<tag_value_t<_Tag>> get(exif_t const& exif);
+    template <typename _Tag, ifd_kind_t _Ifd = _Tag::ifd>
+    bb::optional<tag_value_t<_Tag>> get(exif_view_t const& exif);
+    
+    // Empty if the type or the count is not of _Tag
+    template <typename _Tag>
+    bb::optional<tag_value_t<_Tag>> decode_tag(ifd_value_view_t const& value) {
+        bool const is_type_matched = value.type() == _Tag::type || (_Tag::type == ifd_tag_type_t::long_ && value.type() == ifd_tag_type_t::short_);
+        // the count of ASCII is not checked, the string ends at NUL anyway
+        bool const is_count_matched = _Tag::count == 0 || _Tag::type == ifd_tag_type_t::ascii || value.value_count() == _Tag::count;
+        if (!is_type_matched || !is_count_matched) {
+            return bb::nullopt;
+        }
+        return tag_decoder<_Tag::type, _Tag::count>::decode(value);
+    }
+    
+    // ifd: values are in the native byte order, the returned value refers to them if it is not scalar
+    template <typename _Tag>
+    bb::optional<tag_value_t<_Tag>> get(ifd_t const& ifd) {
+        auto it = ifd.find(_Tag::id);
+        if (it == ifd.end()) {
+            return bb::nullopt;
+        }
+        auto const& data = it->second.data();
+        return decode_tag<_Tag>({it->second.type(), it->second.value_count(), reinterpret_cast<uint8_t const*>(data.data()), data.size(), bb::byte_order_t::native});
+    }
+    
+    // The returned value refers to the source of ifd if it is not scalar
+    template <typename _Tag>
+    bb::optional<tag_value_t<_Tag>> get(ifd_view_t const& ifd) {
+        auto const entry = ifd.find(_Tag::id);
+        if (!entry) {
+            return bb::nullopt;
+        }
+        return decode_tag<_Tag>(ifd.value(*entry));
+    }
+    
+    template <typename _Tag, ifd_kind_t _Ifd>
+    bb::optional<tag_value_t<_Tag>> get(exif_t const& exif) {
+        auto const ifd = tag_ifd<_Ifd>::of(exif);
+        if (!ifd) {
+            return bb::nullopt;
+        }
+        return get<_Tag>(*ifd);
+    }
+    
+    template <typename _Tag, ifd_kind_t _Ifd>
+    bb::optional<tag_value_t<_Tag>> get(exif_view_t const& exif) {
+        auto const ifd = tag_ifd<_Ifd>::of(exif);
+        if (!ifd) {
+            return bb::nullopt;
+        }
+        return get<_Tag>(*ifd);
+    }
+}
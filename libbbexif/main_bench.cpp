@@ -0,0 +1,957 @@
+//
+//  main_bench.cpp
+//  libbbexif
+//
+//  Created by OTAKE Takayoshi on 2026/10/15.
+//  Copyright © 2026 OTAKE Takayoshi. All rights reserved.
+//
+
+// [C++14]
+
+// build: c++ -std=c++14 -O2 -pthread -o bbexif_bench libbbexif/main_bench.cpp
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <streambuf>
+
+#include "bbexif.hpp"
+#include "bbexif_query.hpp"
+#include "bbexif_batch.hpp"
+#include "bbexif_patch.hpp"
+
+#define COMMAND_NAME "bbexif_bench"
+
+// counts allocations of the process, see bench_suite()
+std::atomic<size_t> number_of_allocations{0};
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    number_of_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(size > 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+struct lines {
+    std::string _str;
+    lines(std::vector<std::string> lines)
+    : _str([&]() {
+        std::stringstream ss;
+        for (auto const& line: lines) {
+            ss << line << std::endl;
+        }
+        return ss.str();
+    }()) {}
+    std::string const& str() const { return _str; }
+};
+
+// prevents the optimizer from removing the benchmarked code
+template <typename _T>
+inline void do_not_optimize(_T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename _F>
+double measure_ns(size_t const iterations, _F f) {
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        f(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+void report(std::string const& name, std::string const& unit, double value) {
+    std::cout << name << "\t" << value << "\t" << unit << std::endl;
+}
+
+// for subcommands without options
+bool reject_arguments(std::list<std::string> const& args) {
+    if (args.empty()) {
+        return false;
+    }
+    std::cout << COMMAND_NAME << ": Error: Unexpected argument: " << args.front() << std::endl;
+    return true;
+}
+
+int bench(std::list<std::string>& args);
+int bench_ifd(std::list<std::string>& args);
+int bench_pmr(std::list<std::string>& args);
+int bench_swap(std::list<std::string>& args);
+int bench_parse(std::list<std::string>& args);
+int bench_batch(std::list<std::string>& args);
+int bench_json(std::list<std::string>& args);
+int bench_suite(std::list<std::string>& args);
+int bench_patch(std::list<std::string>& args);
+
+void show_bench_help() {
+    std::cout << lines({
+        "Usage: " COMMAND_NAME " <subcommands> ...",
+        "",
+        "Subcommands:",
+        "  ifd    Compare bbexif::ifd_t with std::map",
+        "  pmr    Compare bb::monotonic_buffer_resource released after each use with the global heap",
+        "  swap   Compare byte swap kernels",
+        "  parse  Parse synthetic APP1 segments in both byte orders",
+        "  batch  Read synthetic JPEG buffers with 1, 2, 4, ... threads",
+        "  json   Compare bb::json_writer with make_json and stringify",
+        "  suite  Measure each stage on a synthetic Exif corpus",
+        "  patch  Check patched tags by reading them again, and measure planning patches",
+        "",
+        "Options for suite:",
+        "  --json              Write a line of JSON for each result instead of TSV",
+        "  --iterations <n>    Iterations for each stage (default: about 0.2s for each)",
+        "  --byte-order II|MM  Measure a custom corpus instead of the predefined ones, with these options",
+        "  --tags <n>          Tags in IFD0",
+        "  --array <n>         LONG values of StripOffsets in IFD0",
+        "  --exif-tags <n>     Tags in the Exif IFD, 0 means no Exif IFD",
+        "  --gps-tags <n>      Tags in the GPS IFD, 0 means no GPS IFD",
+        "  --thumbnail <n>     Bytes of the thumbnail in IFD1, 0 means no IFD1",
+    }).str() << std::endl;
+}
+
+int bench(std::list<std::string>& args) {
+    if (args.size() == 0) {
+        show_bench_help();
+        return 0;
+    }
+    
+    // <subcommands>
+    auto subcommand = args.front();
+    args.pop_front();
+    if (subcommand.compare("ifd") == 0) {
+        return bench_ifd(args);
+    }
+    else if (subcommand.compare("pmr") == 0) {
+        return bench_pmr(args);
+    }
+    else if (subcommand.compare("swap") == 0) {
+        return bench_swap(args);
+    }
+    else if (subcommand.compare("parse") == 0) {
+        return bench_parse(args);
+    }
+    else if (subcommand.compare("batch") == 0) {
+        return bench_batch(args);
+    }
+    else if (subcommand.compare("json") == 0) {
+        return bench_json(args);
+    }
+    else if (subcommand.compare("suite") == 0) {
+        return bench_suite(args);
+    }
+    else if (subcommand.compare("patch") == 0) {
+        return bench_patch(args);
+    }
+    else {
+        show_bench_help();
+        return 0;
+    }
+}
+
+// writes values in the specified byte order
+struct app1_writer {
+    bb::byte_order_t byte_order;
+    std::vector<char> data;
+    
+    void write(uint8_t const* ptr, size_t const size) {
+        data.insert(data.end(), ptr, ptr + size);
+    }
+    
+    template <typename _T>
+    void write(_T value) {
+        if (byte_order != bb::native_byte_order()) {
+            value = bb::byte_swap(value);
+        }
+        write(reinterpret_cast<uint8_t const*>(&value), sizeof(_T));
+    }
+    
+    template <typename _T>
+    void write_at(size_t const offset, _T value) {
+        if (byte_order != bb::native_byte_order()) {
+            value = bb::byte_swap(value);
+        }
+        std::memcpy(data.data() + offset, &value, sizeof(_T));
+    }
+};
+
+// APP1 segment (without the marker and the length) with IFD0 of number_of_tags SHORT tags and a LONG array tag
+std::vector<char> make_app1_segment(bb::byte_order_t const byte_order, size_t const number_of_tags, size_t const array_size) {
+    app1_writer w{byte_order, {}};
+    w.write(reinterpret_cast<uint8_t const*>("Exif\0\0"), 6);
+    size_t const tiff = w.data.size();
+    w.write(reinterpret_cast<uint8_t const*>(byte_order == bb::byte_order_t::little_endian ? "II" : "MM"), 2);
+    w.write<uint16_t>(0x002A);
+    w.write<uint32_t>(8);
+    // IFD0
+    w.write<uint16_t>(static_cast<uint16_t>(number_of_tags + 1));
+    for (size_t i = 0; i < number_of_tags; ++i) {
+        w.write<uint16_t>(static_cast<uint16_t>(0x0100 + i));
+        w.write<uint16_t>(3);
+        w.write<uint32_t>(1);
+        w.write<uint16_t>(static_cast<uint16_t>(i));
+        w.write<uint16_t>(0);
+    }
+    w.write<uint16_t>(0x0111); // StripOffsets
+    w.write<uint16_t>(4);
+    w.write<uint32_t>(static_cast<uint32_t>(array_size));
+    size_t const array_offset_position = w.data.size();
+    w.write<uint32_t>(0);
+    w.write<uint32_t>(0); // no next IFD
+    w.write_at<uint32_t>(array_offset_position, static_cast<uint32_t>(w.data.size() - tiff));
+    for (size_t i = 0; i < array_size; ++i) {
+        w.write<uint32_t>(static_cast<uint32_t>(i * 4096));
+    }
+    return w.data;
+}
+
+template <typename _Ifd>
+void bench_ifd_container(std::string const& name, std::vector<bbexif::ifd_tag_id_t> const& ids) {
+    size_t const iterations = 100000;
+    // construction (in ascending order, as recorded in files)
+    report(name + ".construct", "ns/ifd", measure_ns(iterations, [&ids](size_t) {
+        _Ifd ifd;
+        for (auto const& id: ids) {
+            ifd.emplace_hint(ifd.end(), id, bbexif::ifd_value_t{bbexif::ifd_tag_type_t::short_, 1, bbexif::data_t(2)});
+        }
+        do_not_optimize(ifd);
+    }));
+    
+    _Ifd ifd;
+    for (auto const& id: ids) {
+        ifd.emplace_hint(ifd.end(), id, bbexif::ifd_value_t{bbexif::ifd_tag_type_t::short_, 1, bbexif::data_t(2)});
+    }
+    // lookup (hits and misses in random order)
+    std::vector<bbexif::ifd_tag_id_t> keys;
+    uint32_t seed = 1;
+    for (size_t i = 0; i < 4096; ++i) {
+        seed = seed * 1103515245 + 12345;
+        keys.push_back(static_cast<bbexif::ifd_tag_id_t>(ids[(seed >> 16) % ids.size()] + ((seed >> 8) & 1)));
+    }
+    report(name + ".lookup", "ns/lookup", measure_ns(iterations * 10, [&ifd, &keys](size_t i) {
+        do_not_optimize(ifd.count(keys[i % keys.size()]));
+    }));
+}
+
+int bench_ifd(std::list<std::string>& args) {
+    if (reject_arguments(args)) {
+        return -1;
+    }
+    
+    // typical number of tags in IFD0 and Exif IFD
+    for (size_t number_of_tags: {8, 40, 80}) {
+        std::vector<bbexif::ifd_tag_id_t> ids;
+        for (size_t i = 0; i < number_of_tags; ++i) {
+            ids.push_back(static_cast<bbexif::ifd_tag_id_t>(0x0100 + i * 7));
+        }
+        auto suffix = "[" + std::to_string(number_of_tags) + "]";
+        bench_ifd_container<bbexif::ifd_t>("flat_map" + suffix, ids);
+        bench_ifd_container<std::map<bbexif::ifd_tag_id_t, bbexif::ifd_value_t>>("std::map" + suffix, ids);
+    }
+    return 0;
+}
+
+int bench_pmr(std::list<std::string>& args) {
+    if (reject_arguments(args)) {
+        return -1;
+    }
+    
+    // tag data and a thumbnail of a parse, the resource is released after each as make_exif() recommends
+    size_t const iterations = 100000;
+    bb::monotonic_buffer_resource resource;
+    auto const initial_chunk_size = resource.next_chunk_size_;
+    report("monotonic.release", "ns/cycle", measure_ns(iterations, [&resource](size_t) {
+        for (size_t i = 0; i < 16; ++i) {
+            bbexif::data_t data(8, bbexif::data_t::allocator_type(&resource));
+            do_not_optimize(data.data());
+        }
+        bbexif::data_t thumbnail(8 * 1024, bbexif::data_t::allocator_type(&resource));
+        do_not_optimize(thumbnail.data());
+        resource.release();
+    }));
+    report("new_delete", "ns/cycle", measure_ns(iterations, [](size_t) {
+        for (size_t i = 0; i < 16; ++i) {
+            bbexif::data_t data(8);
+            do_not_optimize(data.data());
+        }
+        bbexif::data_t thumbnail(8 * 1024);
+        do_not_optimize(thumbnail.data());
+    }));
+    // chunks must not grow over cycles
+    if (resource.next_chunk_size_ != initial_chunk_size) {
+        std::cout << COMMAND_NAME << ": Error: the chunk size grows to " << resource.next_chunk_size_ << " bytes after release()" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int bench_swap(std::list<std::string>& args) {
+    if (reject_arguments(args)) {
+        return -1;
+    }
+    
+    // e.g. StripOffsets of a large image
+    size_t const count = 16 * 1024;
+    std::vector<uint8_t> src(count * 4);
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = static_cast<uint8_t>(i * 31);
+    }
+    auto const bo = bb::native_byte_order() == bb::byte_order_t::little_endian ? bb::byte_order_t::big_endian : bb::byte_order_t::little_endian;
+    
+    for (size_t word_size: {2, 4}) {
+        auto const n = src.size() / word_size;
+        std::vector<uint8_t> expected(src.size());
+        std::vector<uint8_t> dst(src.size());
+        auto mr = bb::memory_reader(src.data(), src.size());
+        auto name = "swap" + std::to_string(word_size * 8);
+        report(name + ".peek", "ns/value", measure_ns(1000, [&](size_t) {
+            for (size_t i = 0; i < n; ++i) {
+                if (word_size == 2) {
+                    *reinterpret_cast<uint16_t*>(expected.data() + i * 2) = bb::peek<uint16_t>(mr, i * 2, bo);
+                }
+                else {
+                    *reinterpret_cast<uint32_t*>(expected.data() + i * 4) = bb::peek<uint32_t>(mr, i * 4, bo);
+                }
+            }
+            do_not_optimize(expected.data());
+        }) / n);
+        for (auto level: {bb::simd_level_t::scalar, bb::simd_level_t::ssse3, bb::simd_level_t::avx2}) {
+            if (static_cast<int>(level) > static_cast<int>(bb::simd_level())) {
+                break;
+            }
+            static char const* const level_names[] = {"scalar", "ssse3", "avx2"};
+            report(name + "." + level_names[static_cast<int>(level)], "ns/value", measure_ns(1000, [&](size_t) {
+                bb::swap_bytes_copy(dst.data(), src.data(), n, word_size, level);
+                do_not_optimize(dst.data());
+            }) / n);
+            if (dst != expected) {
+                std::cout << COMMAND_NAME << ": Error: " << name << " mismatch" << std::endl;
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int bench_parse(std::list<std::string>& args) {
+    if (reject_arguments(args)) {
+        return -1;
+    }
+    
+    for (auto bo: {bb::byte_order_t::little_endian, bb::byte_order_t::big_endian}) {
+        auto name = std::string(bo == bb::byte_order_t::little_endian ? "II" : "MM");
+        auto app1 = make_app1_segment(bo, 64, 256);
+        report(name + ".view", "ns/parse", measure_ns(100000, [&app1](size_t) {
+            do_not_optimize(bbexif::read_exif_view_from_app1_segment(app1.data(), app1.size()));
+        }));
+        report(name + ".exif", "ns/parse", measure_ns(100000, [&app1](size_t) {
+            do_not_optimize(bbexif::read_exif_from_app1_segment(app1.data(), app1.size()));
+        }));
+        std::vector<bbexif::tag_query_t> const queries = {
+            { bbexif::ifd_kind_t::ifd0, 0x0102 },
+            { bbexif::ifd_kind_t::ifd0, 0x0110 },
+        };
+        report(name + ".query", "ns/parse", measure_ns(100000, [&app1, &queries](size_t) {
+            do_not_optimize(bbexif::query_exif_view_from_app1_segment(app1.data(), app1.size(), queries));
+        }));
+        
+        // reading scalars with the byte order at runtime and at compile time
+        auto mr = bb::memory_reader(reinterpret_cast<uint8_t const*>(app1.data()), app1.size() / 4 * 4);
+        auto const n = mr.size() / 4;
+        report(name + ".read32.runtime", "ns/value", measure_ns(10000, [&mr, n, bo](size_t) {
+            uint32_t sum = 0;
+            for (size_t i = 0; i < n; ++i) {
+                sum += bb::peek<uint32_t>(mr, i * 4, bo);
+            }
+            do_not_optimize(sum);
+        }) / n);
+        report(name + ".read32.static", "ns/value", measure_ns(10000, [&mr, n, bo](size_t) {
+            uint32_t sum = 0;
+            if (bo == bb::byte_order_t::big_endian) {
+                for (size_t i = 0; i < n; ++i) {
+                    sum += bb::peek<uint32_t, bb::byte_order_t::big_endian>(mr, i * 4);
+                }
+            }
+            else {
+                for (size_t i = 0; i < n; ++i) {
+                    sum += bb::peek<uint32_t, bb::byte_order_t::little_endian>(mr, i * 4);
+                }
+            }
+            do_not_optimize(sum);
+        }) / n);
+    }
+    return 0;
+}
+
+// JPEG file (SOI and APP1 segment only)
+std::vector<char> make_jpeg(std::vector<char> const& app1) {
+    std::vector<char> jpeg = { '\xFF', '\xD8', '\xFF', '\xE1' };
+    jpeg.push_back(static_cast<char>((app1.size() + 2) >> 8));
+    jpeg.push_back(static_cast<char>((app1.size() + 2) & 0xFF));
+    jpeg.insert(jpeg.end(), app1.begin(), app1.end());
+    return jpeg;
+}
+
+int bench_batch(std::list<std::string>& args) {
+    if (reject_arguments(args)) {
+        return -1;
+    }
+    
+    size_t const number_of_files = 4096;
+    std::vector<std::vector<char>> jpegs;
+    std::vector<bbexif::batch_buffer_t> buffers;
+    for (size_t i = 0; i < number_of_files; ++i) {
+        jpegs.push_back(make_jpeg(make_app1_segment(i % 2 == 0 ? bb::byte_order_t::little_endian : bb::byte_order_t::big_endian, 64, 256)));
+    }
+    for (auto const& jpeg: jpegs) {
+        buffers.emplace_back(jpeg.data(), jpeg.size());
+    }
+    
+    std::vector<size_t> thread_counts = {1, 2, 4};
+    auto const hardware_concurrency = std::thread::hardware_concurrency();
+    if (hardware_concurrency > 4) {
+        thread_counts.push_back(hardware_concurrency);
+    }
+    for (auto number_of_threads: thread_counts) {
+        bb::thread_pool pool(number_of_threads);
+        bbexif::batch_options_t options;
+        options.pool = &pool;
+        size_t failed = 0;
+        auto const ns = measure_ns(10, [&](size_t) {
+            auto results = bbexif::read_exif_batch(buffers, options);
+            for (auto const& result: results) {
+                failed += result.is_succeeded() ? 0 : 1;
+            }
+        });
+        if (failed > 0) {
+            std::cout << COMMAND_NAME << ": Error: batch failed" << std::endl;
+            return -1;
+        }
+        report("batch[" + std::to_string(number_of_threads) + "]", "files/s", number_of_files / (ns / 1e9));
+    }
+    return 0;
+}
+
+int bench_json(std::list<std::string>& args) {
+    if (reject_arguments(args)) {
+        return -1;
+    }
+    
+    auto app1 = make_app1_segment(bb::byte_order_t::little_endian, 64, 256);
+    auto const exif = bbexif::read_exif_from_app1_segment(app1.data(), app1.size());
+    for (auto is_pretty: {false, true}) {
+        auto name = std::string(is_pretty ? "pretty" : "compact");
+        report(name + ".stringify", "ns/exif", measure_ns(10000, [&exif, is_pretty](size_t) {
+            do_not_optimize(is_pretty ? bb::stringify(bb::make_json(exif), 0, 2) : bb::stringify(bb::make_json(exif)));
+        }));
+        report(name + ".writer", "ns/exif", measure_ns(10000, [&exif, is_pretty](size_t) {
+            bb::json_writer writer(0, is_pretty ? 2 : -1);
+            bb::write_json(writer, exif);
+            do_not_optimize(writer.str());
+        }));
+    }
+    
+    // e.g. a 32KB thumbnail
+    std::vector<uint8_t> thumbnail(32 * 1024);
+    for (size_t i = 0; i < thumbnail.size(); ++i) {
+        thumbnail[i] = static_cast<uint8_t>(i * 31);
+    }
+    report("thumbnail.hex.stringstream", "ns/byte", measure_ns(100, [&thumbnail](size_t) {
+        std::stringstream ss;
+        ss << std::setfill('0') << std::hex;
+        for (size_t i = 0; i < thumbnail.size(); ++i) {
+            if (i > 0) {
+                ss << ",";
+            }
+            ss << std::setw(2) << +thumbnail[i];
+        }
+        do_not_optimize(ss.str());
+    }) / thumbnail.size());
+    report("thumbnail.hex.table", "ns/byte", measure_ns(1000, [&thumbnail](size_t) {
+        std::string str;
+        bb::append_hex(str, thumbnail.data(), thumbnail.size(), ',');
+        do_not_optimize(str);
+    }) / thumbnail.size());
+    report("thumbnail.base64", "ns/byte", measure_ns(1000, [&thumbnail](size_t) {
+        std::string str;
+        bb::append_base64(str, thumbnail.data(), thumbnail.size());
+        do_not_optimize(str);
+    }) / thumbnail.size());
+    return 0;
+}
+
+struct corpus_spec_t {
+    std::string name;
+    bb::byte_order_t byte_order;
+    size_t number_of_tags; // in IFD0, besides StripOffsets and pointers to sub IFDs
+    size_t array_size; // LONG values of StripOffsets in IFD0, 0 means none
+    size_t number_of_exif_tags; // 0 means no Exif IFD
+    size_t number_of_gps_tags; // 0 means no GPS IFD
+    size_t thumbnail_size; // 0 means no IFD1
+};
+
+struct synthetic_tag_t {
+    bbexif::ifd_tag_id_t id;
+    uint16_t type; // recorded in the file (e.g. 3: SHORT)
+    uint32_t count;
+    std::vector<char> data; // in the byte order of the segment
+};
+
+// SHORT, LONG, ASCII and RATIONAL tags in turn, both of inline and offset values
+std::vector<synthetic_tag_t> make_synthetic_tags(bb::byte_order_t const byte_order, bbexif::ifd_tag_id_t const first_id, size_t const number_of_tags) {
+    std::vector<synthetic_tag_t> tags;
+    for (size_t i = 0; i < number_of_tags; ++i) {
+        app1_writer v{byte_order, {}};
+        auto const id = static_cast<bbexif::ifd_tag_id_t>(first_id + i);
+        switch (i % 4) {
+            case 0:
+                v.write<uint16_t>(static_cast<uint16_t>(i));
+                tags.push_back({id, 3, 1, std::move(v.data)});
+                break;
+            case 1:
+                v.write<uint32_t>(static_cast<uint32_t>(i * 65537));
+                tags.push_back({id, 4, 1, std::move(v.data)});
+                break;
+            case 2: {
+                char ascii[16] = {};
+                std::snprintf(ascii, sizeof(ascii), "tag %u", static_cast<unsigned>(i));
+                v.write(reinterpret_cast<uint8_t const*>(ascii), sizeof(ascii));
+                tags.push_back({id, 2, static_cast<uint32_t>(sizeof(ascii)), std::move(v.data)});
+                break;
+            }
+            default:
+                v.write<uint32_t>(static_cast<uint32_t>(i));
+                v.write<uint32_t>(100);
+                tags.push_back({id, 5, 1, std::move(v.data)});
+                break;
+        }
+    }
+    return tags;
+}
+
+// Writes an IFD followed by its offset values, and returns the position of the value field of each tag
+// next_ifd_offset_position: of the offset to the next IFD, which is written as 0
+std::vector<size_t> write_ifd(app1_writer& w, size_t const tiff, std::vector<synthetic_tag_t> const& tags, size_t& next_ifd_offset_position) {
+    std::vector<size_t> value_positions;
+    w.write<uint16_t>(static_cast<uint16_t>(tags.size()));
+    for (auto const& tag: tags) {
+        w.write<uint16_t>(tag.id);
+        w.write<uint16_t>(tag.type);
+        w.write<uint32_t>(tag.count);
+        value_positions.push_back(w.data.size());
+        char value[4] = {};
+        if (tag.data.size() <= sizeof(value)) {
+            std::memcpy(value, tag.data.data(), tag.data.size());
+        }
+        w.write(reinterpret_cast<uint8_t const*>(value), sizeof(value));
+    }
+    next_ifd_offset_position = w.data.size();
+    w.write<uint32_t>(0);
+    for (size_t i = 0; i < tags.size(); ++i) {
+        if (tags[i].data.size() > 4) {
+            w.write_at<uint32_t>(value_positions[i], static_cast<uint32_t>(w.data.size() - tiff));
+            w.write(reinterpret_cast<uint8_t const*>(tags[i].data.data()), tags[i].data.size());
+        }
+    }
+    return value_positions;
+}
+
+// APP1 segment (without the marker and the length): IFD0, IFD1 with the thumbnail, Exif IFD and GPS IFD
+std::vector<char> make_app1_segment(corpus_spec_t const& spec) {
+    static bbexif::ifd_tag_id_t const exif_ifd_tag_id = 0x8769;
+    static bbexif::ifd_tag_id_t const gps_ifd_tag_id = 0x8825;
+    auto const bo = spec.byte_order;
+    app1_writer w{bo, {}};
+    w.write(reinterpret_cast<uint8_t const*>("Exif\0\0"), 6);
+    size_t const tiff = w.data.size();
+    w.write(reinterpret_cast<uint8_t const*>(bo == bb::byte_order_t::little_endian ? "II" : "MM"), 2);
+    w.write<uint16_t>(0x002A);
+    w.write<uint32_t>(8);
+    
+    // IFD0, sorted by id
+    std::vector<synthetic_tag_t> ifd0;
+    if (spec.array_size > 0) {
+        app1_writer v{bo, {}};
+        for (size_t i = 0; i < spec.array_size; ++i) {
+            v.write<uint32_t>(static_cast<uint32_t>(i * 4096));
+        }
+        ifd0.push_back({0x0111, 4, static_cast<uint32_t>(spec.array_size), std::move(v.data)});
+    }
+    for (auto& tag: make_synthetic_tags(bo, 0x1000, spec.number_of_tags)) {
+        ifd0.push_back(std::move(tag));
+    }
+    auto const pointer_data = std::vector<char>(4);
+    if (spec.number_of_exif_tags > 0) {
+        ifd0.push_back({exif_ifd_tag_id, 4, 1, pointer_data});
+    }
+    if (spec.number_of_gps_tags > 0) {
+        ifd0.push_back({gps_ifd_tag_id, 4, 1, pointer_data});
+    }
+    size_t next_ifd_offset_position;
+    auto const ifd0_value_positions = write_ifd(w, tiff, ifd0, next_ifd_offset_position);
+    auto const patch_pointer = [&](bbexif::ifd_tag_id_t const id) {
+        for (size_t i = 0; i < ifd0.size(); ++i) {
+            if (ifd0[i].id == id) {
+                w.write_at<uint32_t>(ifd0_value_positions[i], static_cast<uint32_t>(w.data.size() - tiff));
+            }
+        }
+    };
+    
+    // IFD1
+    if (spec.thumbnail_size > 0) {
+        w.write_at<uint32_t>(next_ifd_offset_position, static_cast<uint32_t>(w.data.size() - tiff));
+        app1_writer compression{bo, {}};
+        compression.write<uint16_t>(6); // JPEG
+        std::vector<synthetic_tag_t> ifd1 = {
+            {0x0103, 3, 1, std::move(compression.data)},
+            {0x0201, 4, 1, pointer_data},
+            {0x0202, 4, 1, pointer_data},
+        };
+        auto const ifd1_value_positions = write_ifd(w, tiff, ifd1, next_ifd_offset_position);
+        w.write_at<uint32_t>(ifd1_value_positions[1], static_cast<uint32_t>(w.data.size() - tiff));
+        w.write_at<uint32_t>(ifd1_value_positions[2], static_cast<uint32_t>(spec.thumbnail_size));
+        std::vector<uint8_t> thumbnail(spec.thumbnail_size);
+        for (size_t i = 0; i < thumbnail.size(); ++i) {
+            thumbnail[i] = static_cast<uint8_t>(i * 31);
+        }
+        w.write(thumbnail.data(), thumbnail.size());
+    }
+    
+    if (spec.number_of_exif_tags > 0) {
+        patch_pointer(exif_ifd_tag_id);
+        write_ifd(w, tiff, make_synthetic_tags(bo, 0x9000, spec.number_of_exif_tags), next_ifd_offset_position);
+    }
+    if (spec.number_of_gps_tags > 0) {
+        patch_pointer(gps_ifd_tag_id);
+        write_ifd(w, tiff, make_synthetic_tags(bo, 0x0000, spec.number_of_gps_tags), next_ifd_offset_position);
+    }
+    return w.data;
+}
+
+// std::istream over memory without copying, seekable as std::ifstream
+struct memory_streambuf: std::streambuf {
+    memory_streambuf(char const* ptr, size_t const size) {
+        auto p = const_cast<char*>(ptr);
+        setg(p, p, p + size);
+    }
+    
+    pos_type seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode) override {
+        auto base = dir == std::ios::beg ? eback() : dir == std::ios::cur ? gptr() : egptr();
+        if (off < eback() - base || egptr() - base < off) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), base + off, egptr());
+        return pos_type(gptr() - eback());
+    }
+    
+    pos_type seekpos(pos_type pos, std::ios::openmode which) override {
+        return seekoff(off_type(pos), std::ios::beg, which);
+    }
+};
+
+struct suite_result_t {
+    std::string corpus;
+    std::string stage;
+    size_t iterations;
+    double ns_per_file;
+    double allocations_per_file;
+};
+
+// Runs f for iterations (or about 0.2s if 0), and measures ns and allocations for each
+template <typename _F>
+suite_result_t measure_stage(std::string const& corpus, std::string const& stage, size_t iterations, _F f) {
+    if (iterations == 0) {
+        auto const ns = measure_ns(10, f);
+        iterations = static_cast<size_t>(std::min(std::max(2e8 / ns, 10.0), 1e6));
+    }
+    auto const allocations = number_of_allocations.load();
+    auto const ns = measure_ns(iterations, f);
+    auto const allocations_per_file = static_cast<double>(number_of_allocations.load() - allocations) / iterations;
+    return {corpus, stage, iterations, ns, allocations_per_file};
+}
+
+int bench_suite(std::list<std::string>& args) {
+    bool is_json = false;
+    size_t iterations = 0;
+    corpus_spec_t custom{"custom", bb::byte_order_t::little_endian, 16, 0, 40, 10, 8 * 1024};
+    bool is_custom = false;
+    while (!args.empty()) {
+        auto option = args.front();
+        args.pop_front();
+        if (option.compare("--json") == 0) {
+            is_json = true;
+            continue;
+        }
+        if (args.empty()) {
+            std::cout << COMMAND_NAME << ": Error: " << option << " requires a value" << std::endl;
+            return -1;
+        }
+        auto value = args.front();
+        args.pop_front();
+        if (option.compare("--byte-order") == 0 && (value.compare("II") == 0 || value.compare("MM") == 0)) {
+            custom.byte_order = value.compare("II") == 0 ? bb::byte_order_t::little_endian : bb::byte_order_t::big_endian;
+            is_custom = true;
+            continue;
+        }
+        size_t* target = nullptr;
+        if (option.compare("--iterations") == 0) {
+            target = &iterations;
+        }
+        else if (option.compare("--tags") == 0) {
+            target = &custom.number_of_tags;
+        }
+        else if (option.compare("--array") == 0) {
+            target = &custom.array_size;
+        }
+        else if (option.compare("--exif-tags") == 0) {
+            target = &custom.number_of_exif_tags;
+        }
+        else if (option.compare("--gps-tags") == 0) {
+            target = &custom.number_of_gps_tags;
+        }
+        else if (option.compare("--thumbnail") == 0) {
+            target = &custom.thumbnail_size;
+        }
+        if (!target || value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+            std::cout << COMMAND_NAME << ": Error: Invalid option: " << option << " " << value << std::endl;
+            return -1;
+        }
+        *target = std::stoul(value);
+        is_custom = is_custom || target != &iterations;
+    }
+    
+    std::vector<corpus_spec_t> specs;
+    if (is_custom) {
+        specs.push_back(custom);
+    }
+    else {
+        specs = {
+            {"minimal", bb::byte_order_t::little_endian, 8, 0, 0, 0, 0},
+            {"typical.II", bb::byte_order_t::little_endian, 12, 0, 40, 10, 8 * 1024},
+            {"typical.MM", bb::byte_order_t::big_endian, 12, 0, 40, 10, 8 * 1024},
+            {"arrays", bb::byte_order_t::big_endian, 16, 4096, 8, 0, 0},
+            {"large", bb::byte_order_t::little_endian, 200, 256, 400, 30, 32 * 1024},
+        };
+    }
+    
+    if (!is_json) {
+        std::cout << "# corpus.stage\tvalue\tunit" << std::endl;
+    }
+    for (auto const& spec: specs) {
+        auto const app1 = make_app1_segment(spec);
+        if (app1.size() + 2 > 0xFFFF) {
+            std::cout << COMMAND_NAME << ": Error: " << spec.name << ": APP1 segment is too large (" << app1.size() << " bytes)" << std::endl;
+            return -1;
+        }
+        auto const jpeg = make_jpeg(app1);
+        
+        // also checks the corpus is readable as specified
+        auto const exif = bbexif::read_exif_from_app1_segment(app1.data(), app1.size());
+        auto number_of_tags = exif.exif.size() + exif.gps.size();
+        for (auto const& ifd: exif.ifds) {
+            number_of_tags += ifd.size();
+        }
+        auto const expected_number_of_tags = spec.number_of_tags + (spec.array_size > 0 ? 1 : 0) + (spec.number_of_exif_tags > 0 ? 1 + spec.number_of_exif_tags : 0) + (spec.number_of_gps_tags > 0 ? 1 + spec.number_of_gps_tags : 0) + (spec.thumbnail_size > 0 ? 3 : 0);
+        if (number_of_tags != expected_number_of_tags || exif.thumbnail.size() != spec.thumbnail_size) {
+            std::cout << COMMAND_NAME << ": Error: " << spec.name << ": unexpected corpus" << std::endl;
+            return -1;
+        }
+        auto const json = bb::make_json(exif);
+        
+        std::vector<suite_result_t> results;
+        results.push_back(measure_stage(spec.name, "app1", iterations, [&app1](size_t) {
+            do_not_optimize(bbexif::read_exif_from_app1_segment(app1.data(), app1.size()));
+        }));
+        results.push_back(measure_stage(spec.name, "istream", iterations, [&jpeg](size_t) {
+            memory_streambuf streambuf(jpeg.data(), jpeg.size());
+            std::istream is(&streambuf);
+            do_not_optimize(bbexif::read_exif(is));
+        }));
+        results.push_back(measure_stage(spec.name, "make_json", iterations, [&exif](size_t) {
+            do_not_optimize(bb::make_json(exif));
+        }));
+        results.push_back(measure_stage(spec.name, "stringify", iterations, [&json](size_t) {
+            do_not_optimize(bb::stringify(json));
+        }));
+        
+        // MB/s is of the APP1 segment for every stage, to compare stages
+        for (auto const& result: results) {
+            auto const files_per_s = 1e9 / result.ns_per_file;
+            auto const mb_per_s = app1.size() / result.ns_per_file * 1e3;
+            auto const ns_per_tag = result.ns_per_file / number_of_tags;
+            if (is_json) {
+                bb::json_writer writer;
+                writer.begin_object();
+                writer.key("corpus");
+                writer.string(result.corpus);
+                writer.key("stage");
+                writer.string(result.stage);
+                writer.key("byte_order");
+                writer.string(spec.byte_order == bb::byte_order_t::little_endian ? "II" : "MM");
+                writer.key("tags");
+                writer.number(number_of_tags);
+                writer.key("app1_bytes");
+                writer.number(app1.size());
+                writer.key("iterations");
+                writer.number(result.iterations);
+                writer.key("files_per_s");
+                writer.primitive(std::to_string(files_per_s));
+                writer.key("mb_per_s");
+                writer.primitive(std::to_string(mb_per_s));
+                writer.key("ns_per_tag");
+                writer.primitive(std::to_string(ns_per_tag));
+                writer.key("allocations_per_file");
+                writer.primitive(std::to_string(result.allocations_per_file));
+                writer.end_object();
+                std::cout << writer.str() << std::endl;
+            }
+            else {
+                auto const name = result.corpus + "." + result.stage;
+                report(name, "files/s", files_per_s);
+                report(name, "MB/s", mb_per_s);
+                report(name, "ns/tag", ns_per_tag);
+                report(name, "allocs/file", result.allocations_per_file);
+            }
+        }
+    }
+    return 0;
+}
+
+// New value of a tag in the native byte order, values of RATIONAL are pairs of numerator and denominator
+template <typename _T>
+bbexif::ifd_value_t make_patch_value(bbexif::ifd_tag_type_t const type, std::vector<_T> const& values) {
+    bbexif::data_t data(values.size() * sizeof(_T));
+    std::memcpy(data.data(), values.data(), data.size());
+    auto const value_count = type == bbexif::ifd_tag_type_t::rational ? values.size() / 2 : values.size();
+    return {type, value_count, std::move(data)};
+}
+
+bbexif::ifd_value_t make_patch_value(char const* ascii) {
+    bbexif::data_t data(ascii, ascii + std::strlen(ascii) + 1);
+    auto const value_count = data.size();
+    return {bbexif::ifd_tag_type_t::ascii, value_count, std::move(data)};
+}
+
+bbexif::ifd_t const& ifd_of(bbexif::exif_t const& exif, bbexif::ifd_kind_t const kind) {
+    static bbexif::ifd_t const empty;
+    switch (kind) {
+        case bbexif::ifd_kind_t::ifd0:
+            return exif.ifds.size() > 0 ? exif.ifds[0] : empty;
+        case bbexif::ifd_kind_t::ifd1:
+            return exif.ifds.size() > 1 ? exif.ifds[1] : empty;
+        case bbexif::ifd_kind_t::exif:
+            return exif.exif;
+        case bbexif::ifd_kind_t::gps:
+            return exif.gps;
+    }
+    return empty;
+}
+
+bool is_same_value(bbexif::ifd_value_t const& lhs, bbexif::ifd_value_t const& rhs) {
+    return lhs.type() == rhs.type() && lhs.value_count() == rhs.value_count() && lhs.data().size() == rhs.data().size() && std::equal(lhs.data().begin(), lhs.data().end(), rhs.data().begin());
+}
+
+int bench_patch(std::list<std::string>& args) {
+    if (reject_arguments(args)) {
+        return -1;
+    }
+    
+    using bbexif::ifd_kind_t;
+    using bbexif::ifd_tag_type_t;
+    // See make_synthetic_tags() for the recorded tags
+    std::vector<bbexif::tag_patch_t> const patches = {
+        // SHORT in the entry
+        {ifd_kind_t::ifd0, 0x1000, make_patch_value<uint16_t>(ifd_tag_type_t::short_, {0xBEEF})},
+        // RATIONAL out of the entry, each of the pair is swapped
+        {ifd_kind_t::ifd0, 0x1003, make_patch_value<uint32_t>(ifd_tag_type_t::rational, {4000000001u, 3})},
+        // LONG array of 4 values shrinks to 2 values, the count is rewritten
+        {ifd_kind_t::ifd0, 0x0111, make_patch_value<uint32_t>(ifd_tag_type_t::long_, {0x01020304, 0x05060708})},
+        // ASCII of 16 bytes shrinks to 4 bytes, which are written in the entry
+        {ifd_kind_t::exif, 0x9002, make_patch_value("abc")},
+        {ifd_kind_t::gps, 0x0001, make_patch_value<uint32_t>(ifd_tag_type_t::long_, {0x11223344})},
+    };
+    
+    for (auto const byte_order: {bb::byte_order_t::little_endian, bb::byte_order_t::big_endian}) {
+        corpus_spec_t const spec{byte_order == bb::byte_order_t::little_endian ? "patch.II" : "patch.MM", byte_order, 8, 4, 8, 4, 0};
+        auto jpeg = make_jpeg(make_app1_segment(spec));
+        auto read_jpeg = [&jpeg]() {
+            auto const app1_segment = bbexif::find_app1_segment(jpeg.data(), jpeg.size());
+            return bbexif::read_exif_from_app1_segment(app1_segment.first, app1_segment.second);
+        };
+        auto const original = read_jpeg();
+        
+        // a patch which does not fit writes nothing, even if others fit
+        auto const original_jpeg = jpeg;
+        try {
+            bbexif::patch_exif_in_jpeg(jpeg.data(), jpeg.size(), {patches[0], {ifd_kind_t::ifd0, 0x1000, make_patch_value<uint16_t>(ifd_tag_type_t::short_, {1, 2})}});
+            std::cout << COMMAND_NAME << ": Error: " << spec.name << ": a patch of too many values is accepted" << std::endl;
+            return -1;
+        }
+        catch (std::exception const&) {
+        }
+        if (jpeg != original_jpeg) {
+            std::cout << COMMAND_NAME << ": Error: " << spec.name << ": a rejected patch is written" << std::endl;
+            return -1;
+        }
+        
+        // patched tags are read as the patches, and other tags are not changed
+        bbexif::patch_exif_in_jpeg(jpeg.data(), jpeg.size(), patches);
+        auto const patched = read_jpeg();
+        size_t number_of_tags = 0;
+        for (auto const kind: {ifd_kind_t::ifd0, ifd_kind_t::ifd1, ifd_kind_t::exif, ifd_kind_t::gps}) {
+            auto const& original_ifd = ifd_of(original, kind);
+            auto const& patched_ifd = ifd_of(patched, kind);
+            if (original_ifd.size() != patched_ifd.size()) {
+                std::cout << COMMAND_NAME << ": Error: " << spec.name << ": the number of tags is changed" << std::endl;
+                return -1;
+            }
+            for (auto const& tag: original_ifd) {
+                auto expected = &tag.second;
+                for (auto const& patch: patches) {
+                    if (patch.ifd == kind && patch.id == tag.first) {
+                        expected = &patch.value;
+                    }
+                }
+                if (patched_ifd.count(tag.first) == 0 || !is_same_value(patched_ifd.at(tag.first), *expected)) {
+                    char id[8];
+                    std::snprintf(id, sizeof(id), "0x%04X", tag.first);
+                    std::cout << COMMAND_NAME << ": Error: " << spec.name << ": unexpected value of the tag " << id << std::endl;
+                    return -1;
+                }
+                ++number_of_tags;
+            }
+        }
+        report(spec.name + ".checked", "tags", number_of_tags);
+        
+        auto const app1_segment = bbexif::find_app1_segment(original_jpeg.data(), original_jpeg.size());
+        report(spec.name + ".plan", "ns/file", measure_ns(100000, [&app1_segment, &patches](size_t) {
+            do_not_optimize(bbexif::plan_patches_in_app1_segment(app1_segment.first, app1_segment.second, patches));
+        }));
+    }
+    return 0;
+}
+
+int main(int argc, char const* argv[]) {
+    std::list<std::string> args;
+    for (auto i = 1; i < argc; ++i) {
+        args.push_back(argv[i]);
+    }
+    return bench(args);
+}
@@ -11,10 +11,33 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <chrono>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
 
 #include "bbexif.hpp"
+#include "bbexif_index.hpp"
+#include "bb/scope_exit.hpp"
+#include "bb/thread_pool.hpp"
 
 #define COMMAND_NAME "jsexif"
 
@@ -33,6 +56,10 @@ struct lines {
 
 int jsexif(std::list<std::string>& args);
 int jsexif_read(std::list<std::string>& args);
+int jsexif_scan(std::list<std::string>& args);
+int jsexif_watch(std::list<std::string>& args);
+int jsexif_index(std::list<std::string>& args);
+int jsexif_thumbnail(std::list<std::string>& args);
 
 void show_jsexif_version() {
     std::cout << "jsexif version 1.0" << std::endl;
@@ -47,7 +74,11 @@ void show_jsexif_help() {
         "  --version   Show the jsexif version",
         "",
         "Subcommands:",
-        "  read  Show the exif tags as json",
+        "  read       Show the exif tags as json",
+        "  scan       Show the exif tags of JPEG files in directories as NDJSON",
+        "  watch      Show changes of JPEG files in directories as NDJSON, until the directories are removed (Linux)",
+        "  index      Update the index of JPEG files in directories, see read --index",
+        "  thumbnail  Write the thumbnail (JPEG) to stdout",
     }).str() << std::endl;
 }
 
@@ -56,7 +87,62 @@ void show_jsexif_read_help() {
         "Usage: " COMMAND_NAME " read <jpeg_file> [options]",
         "",
         "Options:",
-        "  --html  Output sample html displays exif json",
+        "  --html                 Output sample html displays exif json",
+        "  --index <index_file>   Read from the index if the file is not modified since indexed",
+        "  --thumbnail <format>   The format of the thumbnail: hex (default), base64, omit or reference",
+        "  --large-data <format>  The format of tag data larger than 64 bytes: hex (default), base64 or omit",
+    }).str() << std::endl;
+}
+
+void show_jsexif_watch_help() {
+    std::cout << lines({
+        "Usage: " COMMAND_NAME " watch <directory>... [options]",
+        "",
+        "Writes a line {\"path\": ..., \"event\": ..., \"exif\": ...} for each change of JPEG files in the directories, in the order of detection:",
+        "  created, modified  with \"exif\" (or \"error\") of the file",
+        "  moved              with \"from\", and \"exif\" only if the file is also modified",
+        "  removed            without \"exif\"",
+        "Changes of a file within the debounce time are merged into one, existing files are not shown.",
+        "",
+        "Options:",
+        "  --debounce <ms>        The time to wait for more changes of a file (default: 500)",
+        "  --threads <n>          The number of parse threads (default: the number of CPUs)",
+        "  --max-inflight <n>     The maximum number of changes being parsed or waiting to be written (default: 256)",
+        "  --thumbnail <format>   The format of the thumbnail: hex (default), base64, omit or reference",
+        "  --large-data <format>  The format of tag data larger than 64 bytes: hex (default), base64 or omit",
+        "  --prefix <bytes>       The bytes to read at first, and the rest of APP1 only if needed (default: 65536)",
+        "  --mmap                 Map files instead of reading them, a file truncated while it is mapped kills the process (SIGBUS)",
+    }).str() << std::endl;
+}
+
+void show_jsexif_index_help() {
+    std::cout << lines({
+        "Usage: " COMMAND_NAME " index <index_file> <directory>... [options]",
+        "",
+        "Makes the index of JPEG files in the directories, parsing only new or modified (size, mtime or inode) files since the last update.",
+        "Files not in the directories are dropped from the index.",
+        "",
+        "Options:",
+        "  --threads <n>          The number of parse threads (default: the number of CPUs)",
+        "  --prefix <bytes>       The bytes to read at first, and the rest of APP1 only if needed (default: 65536)",
+        "  --mmap                 Map files instead of reading them, a file truncated while it is mapped kills the process (SIGBUS)",
+    }).str() << std::endl;
+}
+
+void show_jsexif_scan_help() {
+    std::cout << lines({
+        "Usage: " COMMAND_NAME " scan <directory>... [options]",
+        "",
+        "Writes a line {\"path\": ..., \"exif\": ..., \"warnings\": <count, if any>} or {\"path\": ..., \"error\": ...} for each JPEG file,",
+        "in the order of the directory walk.",
+        "",
+        "Options:",
+        "  --threads <n>          The number of parse threads (default: the number of CPUs)",
+        "  --max-inflight <n>     The maximum number of files being prefetched, parsed or waiting to be written (default: 256)",
+        "  --thumbnail <format>   The format of the thumbnail: hex (default), base64, omit or reference",
+        "  --large-data <format>  The format of tag data larger than 64 bytes: hex (default), base64 or omit",
+        "  --prefix <bytes>       The bytes to read at first, and the rest of APP1 only if needed (default: 65536), and show the I/O stats",
+        "  --mmap                 Map files instead of reading them, a file truncated while it is mapped kills the process (SIGBUS)",
     }).str() << std::endl;
 }
 
@@ -82,6 +168,18 @@ int jsexif(std::list<std::string>& args) {
     if (subcommand.compare("read") == 0) {
         return jsexif_read(args);
     }
+    else if (subcommand.compare("scan") == 0) {
+        return jsexif_scan(args);
+    }
+    else if (subcommand.compare("watch") == 0) {
+        return jsexif_watch(args);
+    }
+    else if (subcommand.compare("index") == 0) {
+        return jsexif_index(args);
+    }
+    else if (subcommand.compare("thumbnail") == 0) {
+        return jsexif_thumbnail(args);
+    }
     else {
         show_jsexif_help();
         return 0;
@@ -90,6 +188,67 @@ int jsexif(std::list<std::string>& args) {
     return 0;
 }
 
+// Writes warnings to stderr, keeping stdout for JSON
+struct stderr_diagnostics_sink_t : bbexif::diagnostics_sink_t {
+    void on_report(bbexif::diagnostic_t const& diagnostic) override {
+        std::cerr << bb::make_log_message("[Warning] %s", bbexif::describe(diagnostic).c_str()) << std::endl;
+    }
+};
+
+// The thumbnail is copied only if it is written in JSON
+bbexif::read_options_t make_read_options(bbexif::json_options_t const& json_options) {
+    bbexif::read_options_t options;
+    options.copies_thumbnail = json_options.thumbnail_encoding == bbexif::binary_encoding_t::hex || json_options.thumbnail_encoding == bbexif::binary_encoding_t::base64;
+    return options;
+}
+
+// Parses "--thumbnail <format>" or "--large-data <format>" at it, and advances it to the format
+bool parse_json_option(std::list<std::string>::const_iterator& it, std::list<std::string>::const_iterator const end, bbexif::json_options_t& options) {
+    auto const& option = *it;
+    if (option.compare("--thumbnail") != 0 && option.compare("--large-data") != 0) {
+        return false;
+    }
+    auto& encoding = option.compare("--thumbnail") == 0 ? options.thumbnail_encoding : options.large_data_encoding;
+    auto const next = std::next(it);
+    if (next == end) {
+        return false;
+    }
+    if (next->compare("hex") == 0) {
+        encoding = bbexif::binary_encoding_t::hex;
+    }
+    else if (next->compare("base64") == 0) {
+        encoding = bbexif::binary_encoding_t::base64;
+    }
+    else if (next->compare("omit") == 0) {
+        encoding = bbexif::binary_encoding_t::omit;
+    }
+    else if (next->compare("reference") == 0 && option.compare("--thumbnail") == 0) {
+        encoding = bbexif::binary_encoding_t::reference;
+    }
+    else {
+        return false;
+    }
+    it = next;
+    return true;
+}
+
+// Falls back to parsing the file if it is not in the index, or modified since indexed
+bbexif::exif_t read_exif_with_index(std::string const& index_filepath, std::string const& filepath, bbexif::read_options_t const& options) {
+    bbexif::exif_index_t index;
+    bbexif::index_key_t key;
+    if (index.open(index_filepath.c_str()) && bbexif::stat_index_key(filepath.c_str(), key)) {
+        auto const record = index.find(filepath);
+        if (record && record->key() == key) {
+            auto exif = bbexif::make_exif(bbexif::value_or_throw(index.exif(*record), filepath));
+            if (options.copies_thumbnail) {
+                exif.thumbnail = bbexif::read_thumbnail(filepath, exif.thumbnail_location);
+            }
+            return exif;
+        }
+    }
+    return bbexif::read_exif(filepath, bbexif::file_access_t::mmap, options);
+}
+
 int jsexif_read(std::list<std::string>& args) {
     if (args.size() == 0) {
         show_jsexif_read_help();
@@ -100,11 +259,17 @@ int jsexif_read(std::list<std::string>& args) {
     args.pop_front();
     
     bool outputs_html = false;
-    for (auto const& option: args) {
+    std::string index_filepath;
+    bbexif::json_options_t json_options;
+    for (auto it = args.cbegin(); it != args.cend(); ++it) {
+        auto const& option = *it;
         if (option.compare("--html") == 0) {
             outputs_html = true;
         }
-        else {
+        else if (option.compare("--index") == 0 && std::next(it) != args.cend()) {
+            index_filepath = *++it;
+        }
+        else if (!parse_json_option(it, args.cend(), json_options)) {
             std::cout << COMMAND_NAME << ": Illegal option: " << option << std::endl;
             show_jsexif_help();
             return 0;
@@ -112,17 +277,22 @@ int jsexif_read(std::list<std::string>& args) {
     }
     
     try {
-        auto exif = bbexif::read_exif(filepath);
+        stderr_diagnostics_sink_t diagnostics;
+        auto read_options = make_read_options(json_options);
+        read_options.diagnostics = &diagnostics;
+        auto exif = index_filepath.empty() ? bbexif::read_exif(filepath, bbexif::file_access_t::mmap, read_options) : read_exif_with_index(index_filepath, filepath, read_options);
+        bb::json_writer writer(0, 2);
+        bb::write_json(writer, exif, json_options);
         if (outputs_html) {
             std::cout << "<!DOCTYPE html><html><body><script>" << std::endl;
-            std::cout << "var exif = " << bb::stringify(bb::make_json(exif), 0, 2) << std::endl;
+            std::cout << "var exif = " << writer.str() << std::endl;
             std::cout << "document.write('<pre>')" << std::endl;
             std::cout << "document.write(JSON.stringify(exif, null, 2))" << std::endl;
             std::cout << "document.write('</pre>')" << std::endl;
             std::cout << "</script></body></html>" << std::endl;
         }
         else {
-            std::cout << bb::stringify(bb::make_json(exif), 0, 2) << std::endl;
+            std::cout << writer.str() << std::endl;
         }
     }
     catch (std::exception const& e) {
@@ -133,6 +303,766 @@ int jsexif_read(std::list<std::string>& args) {
     return 0;
 }
 
+bool is_jpeg_filename(std::string const& filename) {
+    auto const dot = filename.rfind('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    auto extension = filename.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    });
+    return extension == "jpg" || extension == "jpeg" || extension == "jpe" || extension == "jfif";
+}
+
+template <typename _F, typename _D>
+void walk_jpeg_files(std::string const& dirpath, _F f, _D on_directory);
+
+// Calls f(filepath) for each JPEG file under dirpath recursively, in the order of names
+// Symbolic links are not followed
+template <typename _F>
+void walk_jpeg_files(std::string const& dirpath, _F f) {
+    walk_jpeg_files(dirpath, f, [](std::string const&) {
+    });
+}
+
+// Calls on_directory(dirpath) for dirpath and each directory under it, before f() for files in it
+template <typename _F, typename _D>
+void walk_jpeg_files(std::string const& dirpath, _F f, _D on_directory) {
+    on_directory(dirpath);
+    std::vector<std::string> filepaths;
+    std::vector<std::string> dirpaths;
+    {
+        auto dir = opendir(dirpath.c_str());
+        if (!dir) {
+            std::cerr << COMMAND_NAME << ": Warning: Unable to open the directory: " << dirpath << std::endl;
+            return;
+        }
+        auto dir_closer = bb::make_scope_exit([dir]() {
+            closedir(dir);
+        });
+        
+        auto const prefix = dirpath.back() == '/' ? dirpath : dirpath + "/";
+        while (auto entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+            auto const path = prefix + name;
+            auto type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                struct stat st;
+                if (lstat(path.c_str(), &st) != 0) {
+                    continue;
+                }
+                type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+            }
+            if (type == DT_DIR) {
+                dirpaths.push_back(path);
+            }
+            else if (type == DT_REG && is_jpeg_filename(name)) {
+                filepaths.push_back(path);
+            }
+        }
+    }
+    
+    std::sort(filepaths.begin(), filepaths.end());
+    std::sort(dirpaths.begin(), dirpaths.end());
+    for (auto const& filepath: filepaths) {
+        f(filepath);
+    }
+    for (auto const& subdirpath: dirpaths) {
+        walk_jpeg_files(subdirpath, f, on_directory);
+    }
+}
+
+// Starts reading the head of the file (where APP1 is) into the page cache, without waiting
+void prefetch_jpeg_header(std::string const& filepath, size_t const prefetch_size) {
+    auto fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+#if defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fd, 0, prefetch_size, POSIX_FADV_WILLNEED);
+#elif defined(F_RDADVISE)
+    struct radvisory advisory = { 0, static_cast<int>(prefetch_size) };
+    fcntl(fd, F_RDADVISE, &advisory);
+#endif
+    close(fd);
+}
+
+// Writes lines in the order of sequence numbers, and bounds the number of files in the pipeline
+struct scan_writer_t {
+    std::FILE* file_;
+    size_t max_inflight_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<size_t, std::string> lines_; // completed, but not written yet
+    size_t next_sequence_ = 0; // to be acquired
+    size_t written_sequence_ = 0; // to be written
+    bool is_finished_ = false;
+    
+    scan_writer_t(std::FILE* file, size_t max_inflight)
+    : file_(file), max_inflight_(max_inflight) {
+    }
+    
+    // Returns the sequence number for the next file, blocks while max_inflight files are in the pipeline
+    size_t acquire() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() {
+            return next_sequence_ - written_sequence_ < max_inflight_;
+        });
+        return next_sequence_++;
+    }
+    
+    void put(size_t const sequence, std::string&& line) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lines_.emplace(sequence, std::move(line));
+        }
+        cv_.notify_all();
+    }
+    
+    // No more acquire()
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_finished_ = true;
+        }
+        cv_.notify_all();
+    }
+    
+    // Returns after all acquired lines are written and finish() is called
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this]() {
+                return (!lines_.empty() && lines_.begin()->first == written_sequence_) || (is_finished_ && written_sequence_ == next_sequence_);
+            });
+            if (lines_.empty() || lines_.begin()->first != written_sequence_) {
+                break;
+            }
+            auto line = std::move(lines_.begin()->second);
+            lines_.erase(lines_.begin());
+            lock.unlock();
+            std::fwrite(line.data(), 1, line.size(), file_);
+            std::fputc('\n', file_);
+            lock.lock();
+            ++written_sequence_;
+            cv_.notify_all();
+        }
+        std::fflush(file_);
+    }
+};
+
+struct scan_options_t {
+    bbexif::json_options_t json_options;
+    // Crawled files may be written (or truncated) by others, reading fails on them where a mapping raises SIGBUS
+    bbexif::file_access_t access = bbexif::file_access_t::prefix;
+    size_t prefix_size = 64 * 1024;
+    bool reports_stats = false;
+};
+
+// for file_access_t::prefix
+struct scan_stats_t {
+    std::atomic<size_t> number_of_files{0};
+    std::atomic<size_t> number_of_reads{0};
+    std::atomic<uint64_t> bytes_read{0};
+};
+
+// Writes "exif" (and "warnings") or "error" of the file into the current object
+void write_scan_result(bb::json_writer& writer, std::string const& filepath, scan_options_t const& options, scan_stats_t& stats) {
+    auto const& json_options = options.json_options;
+    try {
+        bbexif::read_stats_t read_stats;
+        stderr_diagnostics_sink_t diagnostics;
+        auto read_options = make_read_options(json_options);
+        read_options.prefix_size = options.prefix_size;
+        read_options.stats = &read_stats;
+        read_options.diagnostics = &diagnostics;
+        auto record_stats = bb::make_scope_exit([&stats, &read_stats]() {
+            ++stats.number_of_files;
+            stats.number_of_reads += read_stats.number_of_reads;
+            stats.bytes_read += read_stats.bytes_read;
+        });
+        // non-Exif files are common in a scan, so avoid throwing for them
+        auto exif = bbexif::try_read_exif(filepath, options.access, read_options);
+        if (!exif) {
+            writer.key("error");
+            writer.string(exif.error().message());
+        }
+        else {
+            writer.key("exif");
+            bb::write_json(writer, *exif, json_options);
+            if (diagnostics.total_count() > 0) {
+                writer.key("warnings");
+                writer.number(diagnostics.total_count());
+            }
+        }
+    }
+    catch (std::exception const& e) {
+        writer.key("error");
+        writer.string(e.what());
+    }
+}
+
+std::string make_scan_line(std::string const& filepath, scan_options_t const& options, scan_stats_t& stats) {
+    bb::json_writer writer;
+    writer.begin_object();
+    writer.key("path");
+    writer.string(filepath);
+    write_scan_result(writer, filepath, options, stats);
+    writer.end_object();
+    return std::move(writer.str());
+}
+
+// Pipeline: walk (and prefetch) on this thread -> parse on the thread pool -> write in order on the writer thread
+int jsexif_scan(std::list<std::string>& args) {
+    std::vector<std::string> dirpaths;
+    size_t number_of_threads = 0;
+    size_t max_inflight = 256;
+    scan_options_t options;
+    for (auto it = args.cbegin(); it != args.cend(); ++it) {
+        auto const& arg = *it;
+        if (arg.compare("--mmap") == 0) {
+            options.access = bbexif::file_access_t::mmap;
+        }
+        else if (arg.compare("--threads") == 0 || arg.compare("--max-inflight") == 0 || arg.compare("--prefix") == 0) {
+            size_t value = 0;
+            if (std::next(it) == args.cend() || (value = std::strtoul(std::next(it)->c_str(), nullptr, 10)) == 0) {
+                std::cout << COMMAND_NAME << ": Illegal option: " << arg << std::endl;
+                show_jsexif_scan_help();
+                return 0;
+            }
+            ++it;
+            if (arg.compare("--prefix") == 0) {
+                options.prefix_size = value;
+                options.reports_stats = true;
+            }
+            else {
+                (arg.compare("--threads") == 0 ? number_of_threads : max_inflight) = value;
+            }
+        }
+        else if (parse_json_option(it, args.cend(), options.json_options)) {
+            continue;
+        }
+        else if (arg.compare(0, 2, "--") == 0) {
+            std::cout << COMMAND_NAME << ": Illegal option: " << arg << std::endl;
+            show_jsexif_scan_help();
+            return 0;
+        }
+        else {
+            dirpaths.push_back(arg);
+        }
+    }
+    if (dirpaths.empty()) {
+        show_jsexif_scan_help();
+        return 0;
+    }
+    
+    scan_stats_t stats;
+    scan_writer_t writer(stdout, max_inflight);
+    std::thread writer_thread([&writer]() {
+        writer.run();
+    });
+    {
+        // destruction waits for all submitted tasks
+        bb::thread_pool pool(number_of_threads);
+        for (auto const& dirpath: dirpaths) {
+            walk_jpeg_files(dirpath, [&writer, &pool, &options, &stats](std::string const& filepath) {
+                auto const sequence = writer.acquire();
+                prefetch_jpeg_header(filepath, options.access == bbexif::file_access_t::prefix ? options.prefix_size : 64 * 1024);
+                pool.submit([&writer, sequence, filepath, &options, &stats]() {
+                    writer.put(sequence, make_scan_line(filepath, options, stats));
+                });
+            });
+        }
+    }
+    writer.finish();
+    writer_thread.join();
+    
+    if (options.reports_stats && options.access == bbexif::file_access_t::prefix) {
+        std::cerr << COMMAND_NAME << ": Read " << stats.bytes_read << " bytes by " << stats.number_of_reads << " reads for " << stats.number_of_files << " files" << std::endl;
+    }
+    
+    return 0;
+}
+
+#if defined(__linux__)
+// Tracks JPEG files under directories with inotify, and merges changes of each file within the debounce time
+// Changes are detected by comparing bbexif::index_key_t, so events without changes (e.g. opened for writing, but not written) are ignored
+struct directory_watcher_t {
+    struct pending_t {
+        std::chrono::steady_clock::time_point deadline;
+        std::string moved_from; // known file renamed to this path
+    };
+    
+    struct change_t {
+        std::string path;
+        char const* event; // "created", "modified", "moved" or "removed"
+        std::string from; // for "moved"
+        bool is_modified; // the file should be parsed
+    };
+    
+    static uint32_t const mask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE;
+    
+    int fd_ = -1;
+    std::chrono::milliseconds debounce_;
+    std::vector<std::string> roots_;
+    std::map<int, std::string> directories_; // by watch descriptor
+    std::map<std::string, bbexif::index_key_t> files_; // known JPEG files
+    std::map<std::string, pending_t> pending_;
+    std::map<uint32_t, std::string> moves_; // IN_MOVED_FROM by cookie, waiting for IN_MOVED_TO
+    
+    explicit directory_watcher_t(std::chrono::milliseconds const debounce)
+    : fd_(inotify_init1(IN_CLOEXEC)), debounce_(debounce) {
+    }
+    
+    directory_watcher_t(directory_watcher_t const&) = delete;
+    directory_watcher_t const& operator=(directory_watcher_t const&) = delete;
+    
+    ~directory_watcher_t() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+    
+    bool is_open() const {
+        return fd_ >= 0;
+    }
+    
+    // Returns false after all directories are removed and their changes are taken
+    bool is_watching() const {
+        return !directories_.empty() || !pending_.empty();
+    }
+    
+    void add_root(std::string dirpath) {
+        while (dirpath.size() > 1 && dirpath.back() == '/') {
+            dirpath.pop_back();
+        }
+        roots_.push_back(dirpath);
+        add(dirpath, false);
+    }
+    
+    // Watches dirpath and directories under it, JPEG files in them are known (or pending if is_new, e.g. moved in)
+    void add(std::string const& dirpath, bool const is_new) {
+        walk_jpeg_files(dirpath, [this, is_new](std::string const& filepath) {
+            bbexif::index_key_t key;
+            if (is_new) {
+                touch(filepath);
+            }
+            else if (bbexif::stat_index_key(filepath.c_str(), key)) {
+                files_[filepath] = key;
+            }
+        }, [this](std::string const& path) {
+            auto const wd = inotify_add_watch(fd_, path.c_str(), mask | IN_ONLYDIR);
+            if (wd < 0) {
+                std::cerr << COMMAND_NAME << ": Warning: Unable to watch the directory: " << path << std::endl;
+                return;
+            }
+            directories_[wd] = path;
+        });
+    }
+    
+    // Stops watching dirpath and directories under it, and known files in them are pending to be removed
+    void remove(std::string const& dirpath) {
+        auto const prefix = dirpath + "/";
+        for (auto it = directories_.begin(); it != directories_.end();) {
+            if (it->second == dirpath || it->second.compare(0, prefix.size(), prefix) == 0) {
+                inotify_rm_watch(fd_, it->first);
+                it = directories_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        for (auto it = files_.lower_bound(prefix); it != files_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            touch(it->first);
+        }
+    }
+    
+    pending_t& touch(std::string const& filepath) {
+        auto& pending = pending_[filepath];
+        pending.deadline = std::chrono::steady_clock::now() + debounce_;
+        return pending;
+    }
+    
+    void read_events() {
+        alignas(struct inotify_event) char buffer[64 * 1024];
+        auto const size = read(fd_, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < size;) {
+            auto const event = reinterpret_cast<struct inotify_event const*>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                // changes are lost, so check all files again
+                std::cerr << COMMAND_NAME << ": Warning: Too many changes, checking all files" << std::endl;
+                for (auto const& file: files_) {
+                    touch(file.first);
+                }
+                for (auto const& root: roots_) {
+                    add(root, true);
+                }
+                continue;
+            }
+            auto const directory = directories_.find(event->wd);
+            if (directory == directories_.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // e.g. removed, files in it may not have their own events
+                auto const path = directory->second;
+                directories_.erase(directory);
+                remove(path);
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+            std::string const name = event->name;
+            auto const path = directory->second + "/" + name;
+            if (event->mask & IN_ISDIR) {
+                // files in a renamed directory are removed and created, not moved
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    add(path, true);
+                }
+                else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    remove(path);
+                }
+                continue;
+            }
+            if (!is_jpeg_filename(name)) {
+                continue;
+            }
+            if (event->mask & IN_MOVED_FROM) {
+                touch(path);
+                moves_[event->cookie] = path;
+            }
+            else if ((event->mask & IN_MOVED_TO) && moves_.count(event->cookie) > 0) {
+                auto const from = moves_[event->cookie];
+                moves_.erase(event->cookie);
+                auto const from_pending = pending_.find(from);
+                auto moved_from = from_pending != pending_.end() && !from_pending->second.moved_from.empty() ? from_pending->second.moved_from : from;
+                if (from_pending != pending_.end()) {
+                    pending_.erase(from_pending);
+                }
+                auto& pending = touch(path);
+                if (!pending.moved_from.empty()) {
+                    // overwritten before the previous move is shown
+                    touch(pending.moved_from);
+                }
+                pending.moved_from = moved_from;
+            }
+            else {
+                touch(path);
+            }
+        }
+    }
+    
+    // Returns the timeout for poll() until the next deadline
+    int timeout() const {
+        if (pending_.empty()) {
+            return -1;
+        }
+        auto deadline = pending_.begin()->second.deadline;
+        for (auto const& pending: pending_) {
+            deadline = std::min(deadline, pending.second.deadline);
+        }
+        auto const now = std::chrono::steady_clock::now();
+        if (deadline <= now) {
+            return 0;
+        }
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1;
+    }
+    
+    // Returns changes of files whose deadline is over, in the order of paths
+    std::vector<change_t> take_changes() {
+        std::vector<change_t> changes;
+        auto const now = std::chrono::steady_clock::now();
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (it->second.deadline > now) {
+                ++it;
+                continue;
+            }
+            auto const path = it->first;
+            auto const moved_from = it->second.moved_from;
+            it = pending_.erase(it);
+            for (auto move = moves_.begin(); move != moves_.end();) {
+                // moved out of the directories
+                move = move->second == path ? moves_.erase(move) : std::next(move);
+            }
+            
+            bbexif::index_key_t key;
+            bool const exists = bbexif::stat_index_key(path.c_str(), key);
+            bbexif::index_key_t from_key{0, 0, 0};
+            bool is_moved = false;
+            if (!moved_from.empty()) {
+                auto const from = files_.find(moved_from);
+                if (from != files_.end()) {
+                    from_key = from->second;
+                    files_.erase(from);
+                    is_moved = true;
+                }
+            }
+            auto const file = files_.find(path);
+            if (!exists) {
+                if (is_moved) {
+                    changes.push_back({moved_from, "removed", "", false});
+                }
+                if (file != files_.end()) {
+                    files_.erase(file);
+                    changes.push_back({path, "removed", "", false});
+                }
+            }
+            else if (is_moved) {
+                files_[path] = key;
+                changes.push_back({path, "moved", moved_from, key != from_key});
+            }
+            else if (file == files_.end()) {
+                files_[path] = key;
+                changes.push_back({path, "created", "", true});
+            }
+            else if (file->second != key) {
+                file->second = key;
+                changes.push_back({path, "modified", "", true});
+            }
+        }
+        return changes;
+    }
+};
+#endif
+
+std::string make_watch_line(std::string const& path, char const* event, std::string const& from, scan_options_t const* options, scan_stats_t* stats) {
+    bb::json_writer writer;
+    writer.begin_object();
+    writer.key("path");
+    writer.string(path);
+    writer.key("event");
+    writer.string(event);
+    if (!from.empty()) {
+        writer.key("from");
+        writer.string(from);
+    }
+    if (options) {
+        write_scan_result(writer, path, *options, *stats);
+    }
+    writer.end_object();
+    return std::move(writer.str());
+}
+
+// Pipeline: wait for changes (and debounce) on this thread -> parse on the thread pool -> write in order on the writer thread
+int jsexif_watch(std::list<std::string>& args) {
+    std::vector<std::string> dirpaths;
+    size_t number_of_threads = 0;
+    size_t max_inflight = 256;
+    size_t debounce = 500;
+    scan_options_t options;
+    for (auto it = args.cbegin(); it != args.cend(); ++it) {
+        auto const& arg = *it;
+        if (arg.compare("--mmap") == 0) {
+            options.access = bbexif::file_access_t::mmap;
+        }
+        else if (arg.compare("--threads") == 0 || arg.compare("--max-inflight") == 0 || arg.compare("--prefix") == 0 || arg.compare("--debounce") == 0) {
+            size_t value = 0;
+            if (std::next(it) == args.cend() || (value = std::strtoul(std::next(it)->c_str(), nullptr, 10)) == 0) {
+                std::cout << COMMAND_NAME << ": Illegal option: " << arg << std::endl;
+                show_jsexif_watch_help();
+                return 0;
+            }
+            ++it;
+            if (arg.compare("--prefix") == 0) {
+                options.prefix_size = value;
+            }
+            else if (arg.compare("--debounce") == 0) {
+                debounce = value;
+            }
+            else {
+                (arg.compare("--threads") == 0 ? number_of_threads : max_inflight) = value;
+            }
+        }
+        else if (parse_json_option(it, args.cend(), options.json_options)) {
+            continue;
+        }
+        else if (arg.compare(0, 2, "--") == 0) {
+            std::cout << COMMAND_NAME << ": Illegal option: " << arg << std::endl;
+            show_jsexif_watch_help();
+            return 0;
+        }
+        else {
+            dirpaths.push_back(arg);
+        }
+    }
+    if (dirpaths.empty()) {
+        show_jsexif_watch_help();
+        return 0;
+    }
+
+#if defined(__linux__)
+    directory_watcher_t watcher{std::chrono::milliseconds(debounce)};
+    if (!watcher.is_open()) {
+        std::cerr << COMMAND_NAME << ": Error: Unable to initialize inotify" << std::endl;
+        return -1;
+    }
+    for (auto const& dirpath: dirpaths) {
+        watcher.add_root(dirpath);
+    }
+    std::cerr << COMMAND_NAME << ": Watching " << watcher.files_.size() << " files in " << watcher.directories_.size() << " directories" << std::endl;
+    
+    scan_stats_t stats;
+    scan_writer_t writer(stdout, max_inflight);
+    std::thread writer_thread([&writer]() {
+        writer.run();
+    });
+    {
+        // destruction waits for all submitted tasks
+        bb::thread_pool pool(number_of_threads);
+        while (watcher.is_watching()) {
+            struct pollfd pfd = { watcher.fd_, POLLIN, 0 };
+            auto const result = poll(&pfd, 1, watcher.timeout());
+            if (result < 0 && errno != EINTR) {
+                std::cerr << COMMAND_NAME << ": Error: Unable to wait for changes" << std::endl;
+                break;
+            }
+            if (result > 0) {
+                watcher.read_events();
+            }
+            for (auto& change: watcher.take_changes()) {
+                auto const sequence = writer.acquire();
+                if (!change.is_modified) {
+                    writer.put(sequence, make_watch_line(change.path, change.event, change.from, nullptr, nullptr));
+                    continue;
+                }
+                pool.submit([&writer, sequence, change, &options, &stats]() {
+                    writer.put(sequence, make_watch_line(change.path, change.event, change.from, &options, &stats));
+                });
+            }
+        }
+    }
+    writer.finish();
+    writer_thread.join();
+    return 0;
+#else
+    std::cerr << COMMAND_NAME << ": Error: watch is supported only on Linux" << std::endl;
+    return -1;
+#endif
+}
+
+int jsexif_index(std::list<std::string>& args) {
+    if (args.size() < 2) {
+        show_jsexif_index_help();
+        return 0;
+    }
+    auto const index_filepath = args.front();
+    args.pop_front();
+    
+    std::vector<std::string> dirpaths;
+    bbexif::index_options_t options;
+    for (auto it = args.cbegin(); it != args.cend(); ++it) {
+        auto const& arg = *it;
+        if (arg.compare("--mmap") == 0) {
+            options.access = bbexif::file_access_t::mmap;
+        }
+        else if (arg.compare("--threads") == 0 || arg.compare("--prefix") == 0) {
+            size_t value = 0;
+            if (std::next(it) == args.cend() || (value = std::strtoul(std::next(it)->c_str(), nullptr, 10)) == 0) {
+                std::cout << COMMAND_NAME << ": Illegal option: " << arg << std::endl;
+                show_jsexif_index_help();
+                return 0;
+            }
+            ++it;
+            if (arg.compare("--prefix") == 0) {
+                options.read_options.prefix_size = value;
+            }
+            else {
+                options.number_of_threads = value;
+            }
+        }
+        else if (arg.compare(0, 2, "--") == 0) {
+            std::cout << COMMAND_NAME << ": Illegal option: " << arg << std::endl;
+            show_jsexif_index_help();
+            return 0;
+        }
+        else {
+            dirpaths.push_back(arg);
+        }
+    }
+    if (dirpaths.empty()) {
+        show_jsexif_index_help();
+        return 0;
+    }
+    
+    std::vector<std::string> filepaths;
+    for (auto const& dirpath: dirpaths) {
+        walk_jpeg_files(dirpath, [&filepaths](std::string const& filepath) {
+            filepaths.push_back(filepath);
+        });
+    }
+    try {
+        auto const stats = bbexif::update_index(index_filepath, filepaths, options);
+        std::cerr << COMMAND_NAME << ": Indexed " << stats.number_of_parsed + stats.number_of_reused << " files (parsed " << stats.number_of_parsed << ", reused " << stats.number_of_reused << ", failed " << stats.number_of_failed << ")" << std::endl;
+    }
+    catch (std::exception const& e) {
+        std::cerr << COMMAND_NAME << ": Error: " << e.what() << std::endl;
+        return -1;
+    }
+    
+    return 0;
+}
+
+// Copies the thumbnail from the file to stdout, without reading it into the heap if possible
+int jsexif_thumbnail(std::list<std::string>& args) {
+    if (args.size() != 1) {
+        std::cout << "Usage: " COMMAND_NAME " thumbnail <jpeg_file>" << std::endl;
+        return 0;
+    }
+    auto const& filepath = args.front();
+    
+    try {
+        stderr_diagnostics_sink_t diagnostics;
+        bbexif::read_options_t options;
+        options.copies_thumbnail = false;
+        options.diagnostics = &diagnostics;
+        auto const location = bbexif::read_exif(filepath, bbexif::file_access_t::mmap, options).thumbnail_location;
+        if (location.size == 0) {
+            std::cerr << COMMAND_NAME << ": Error: No thumbnail" << std::endl;
+            return -1;
+        }
+#if defined(__linux__)
+        auto fd = open(filepath.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            auto fd_closer = bb::make_scope_exit([fd]() {
+                close(fd);
+            });
+            auto offset = static_cast<off_t>(location.offset);
+            size_t remaining = location.size;
+            while (remaining > 0) {
+                auto const sent = sendfile(STDOUT_FILENO, fd, &offset, remaining);
+                if (sent <= 0) {
+                    break;
+                }
+                remaining -= static_cast<size_t>(sent);
+            }
+            if (remaining == 0) {
+                return 0;
+            }
+            if (remaining != location.size) {
+                std::cerr << COMMAND_NAME << ": Error: Unable to write the thumbnail" << std::endl;
+                return -1;
+            }
+            // e.g. stdout does not support sendfile()
+        }
+#endif
+        auto const thumbnail = bbexif::read_thumbnail(filepath, location);
+        std::fwrite(thumbnail.data(), 1, thumbnail.size(), stdout);
+        std::fflush(stdout);
+    }
+    catch (std::exception const& e) {
+        std::cerr << COMMAND_NAME << ": Error: " << e.what() << std::endl;
+        return -1;
+    }
+    
+    return 0;
+}
+
 int main(int argc, char const* argv[]) {
     std::list<std::string> args;
     for (auto i = 1; i < argc; ++i) {